@@ -30,12 +30,19 @@ SOURCES="$SOURCES src/lib/stockfish/stockfish_position.cpp"
 SOURCES="$SOURCES src/lib/stockfish/tt.cpp"
 SOURCES="$SOURCES src/lib/stockfish/custom/custom_search.cpp"
 SOURCES="$SOURCES src/lib/stockfish/custom/custommovepicker.cpp"
+SOURCES="$SOURCES src/lib/stockfish/custom/endgame.cpp"
+SOURCES="$SOURCES src/lib/stockfish/custom/eval_cache.cpp"
 SOURCES="$SOURCES src/lib/stockfish/custom/evaluate.cpp"
 SOURCES="$SOURCES src/lib/stockfish/custom/game_over_check.cpp"
+SOURCES="$SOURCES src/lib/stockfish/custom/lazy_smp_search.cpp"
+SOURCES="$SOURCES src/lib/stockfish/custom/material.cpp"
+SOURCES="$SOURCES src/lib/stockfish/custom/pawns.cpp"
 SOURCES="$SOURCES src/lib/stockfish/custom/perft.cpp"
 SOURCES="$SOURCES src/lib/stockfish/custom/pesto_evaluate.cpp"
+SOURCES="$SOURCES src/lib/stockfish/custom/timeman.cpp"
 
-# Compile with emscripten
+# Compile with emscripten. Searches run on std::thread workers, the pool has
+# them ready before main() so a join never waits for the browser event loop
 emcc $SOURCES \
     -I src/lib/shatranj_simple \
     -I src/lib/stockfish \
@@ -43,6 +50,9 @@ emcc $SOURCES \
     -std=c++20 \
     -O3 \
     -DUSE_POPCNT \
+    -pthread \
+    -s USE_PTHREADS=1 \
+    -s PTHREAD_POOL_SIZE=4 \
     -s WASM=1 \
     -s EXPORTED_FUNCTIONS='["_main"]' \
     -s EXPORTED_RUNTIME_METHODS='["callMain"]' \
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Benchmarks of the bitboard engine. Each benchmark is a sub command of the
+// shatranj_bench binary and prints a small report to stdout.
+namespace bench {
+
+struct BenchPosition {
+    std::string fen;
+    bool        shatranj;
+};
+
+const std::vector<BenchPosition>& bench_positions();
+std::vector<std::string>          long_game(int plies);
+
+int threads(const std::vector<std::string>& args);
+int search_depth(const std::vector<std::string>& args);
+int replay(const std::vector<std::string>& args);
+int ebf(const std::vector<std::string>& args);
+int picker(const std::vector<std::string>& args);
+int latency(const std::vector<std::string>& args);
+int clock(const std::vector<std::string>& args);
+int position(const std::vector<std::string>& args);
+int eval(const std::vector<std::string>& args);
+int endgame(const std::vector<std::string>& args);
+int perft(const std::vector<std::string>& args);
+int hash(const std::vector<std::string>& args);
+int snapshot(const std::vector<std::string>& args);
+
+}
@@ -0,0 +1,61 @@
+#include <iomanip>
+#include <iostream>
+
+#include "bench.h"
+#include "custom_search.h"
+#include "helper.h"
+#include "stockfish_position.h"
+#include "timeman.h"
+#include "tt.h"
+
+using namespace Stockfish;
+
+namespace bench {
+
+// Clock usage of the time manager: every bench position is searched as the
+// side to move with time_ms on both clocks. Reports the optimum and maximum
+// the time manager gave the move, the time actually used and the depth
+// reached. No search may use more than its maximum.
+int clock(const std::vector<std::string>& args) {
+    TimePoint time = args.size() > 0 ? std::stoll(args[0]) : 60000;
+    TimePoint inc  = args.size() > 1 ? std::stoll(args[1]) : 0;
+    int       mtg  = args.size() > 2 ? std::stoi(args[2]) : 0;
+
+    TranspositionTable tt;
+    tt.resize(64);
+
+    long long totalUs = 0, totalOptimum = 0, overMaximum = 0;
+    std::cout << std::setw(4) << "#" << std::setw(10) << "optimum" << std::setw(10) << "maximum"
+              << std::setw(10) << "used_ms" << std::setw(8) << "depth" << "  move" << std::endl;
+    for (size_t i = 0; i < bench_positions().size(); ++i)
+    {
+        auto& bp = bench_positions()[i];
+        tt.clear();
+        StateInfo st;
+        Position  pos;
+        pos.set(bp.fen, &st, bp.shatranj);
+
+        LimitsType limits;
+        limits.time[WHITE] = limits.time[BLACK] = time;
+        limits.inc[WHITE] = limits.inc[BLACK] = inc;
+        limits.movestogo                      = mtg;
+        TimeManagement tm;
+        tm.init(limits, pos.side_to_move(), pos.gamePly);
+
+        search<true> s(&tt, pos);
+        Move         m  = Move::none();
+        long long    us = timeit_us([&]() { m = s.iterative_deepening(limits); });
+        totalUs += us;
+        totalOptimum += tm.optimum();
+        overMaximum += us > tm.maximum() * 1000;
+
+        std::cout << std::setw(4) << i << std::setw(10) << tm.optimum() << std::setw(10)
+                  << tm.maximum() << std::setw(10) << us / 1000 << std::setw(8)
+                  << s.completedDepth << "  " << m << std::endl;
+    }
+    std::cout << "used_ms: " << totalUs / 1000 << ", optimum_ms: " << totalOptimum
+              << ", over maximum: " << overMaximum << std::endl;
+    return 0;
+}
+
+}
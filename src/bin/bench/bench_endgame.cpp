@@ -0,0 +1,95 @@
+#include <deque>
+#include <iomanip>
+#include <iostream>
+
+#include "bench.h"
+#include "custom_search.h"
+#include "evaluate.h"
+#include "movegen.h"
+#include "stockfish_position.h"
+#include "tt.h"
+
+using namespace Stockfish;
+
+namespace bench {
+
+namespace {
+
+// Won for white under the bare king rule, white to move
+const std::vector<std::string> endgames = {
+  "8/8/3v4/3s4/8/8/2R5/4S3 w 0 1",   // rook against ferz
+  "8/8/3h4/3s4/8/8/2R5/4S3 w 0 1",   // rook against horse
+  "8/5f2/8/3s4/8/8/2R5/4S3 w 0 1",   // rook against alfil
+  "8/8/8/3s4/3p4/8/2R5/4S3 w 0 1",   // rook against pawn
+  "8/8/8/3s4/8/5H2/2R5/4S3 w 0 1",   // rook and horse against king
+};
+
+struct Conversion {
+    int                      plies;
+    uint64_t                 nodes;
+    GameEndDetector::GameEnd result;
+};
+
+// Plays the position out with a fixed depth search for both sides
+Conversion play_out(const std::string& fen, int depth, int maxPlies) {
+    TranspositionTable tt;
+    tt.resize(16);
+    std::deque<StateInfo> states(1);
+    Position              pos;
+    pos.set(fen, &states.back(), true);
+
+    Conversion c{0, 0, GameEndDetector::None};
+    while (c.plies < maxPlies && (c.result = pos.game_end()) == GameEndDetector::None)
+    {
+        Stockfish::search<false> s(&tt, pos);
+        Move                     m = s.iterative_deepening(depth);
+        c.nodes += s.nodes_searched();
+        if (m == Move::none())
+            break;
+        states.emplace_back();
+        pos.do_move(m, states.back());
+        c.plies++;
+    }
+    return c;
+}
+
+const char* result_name(GameEndDetector::GameEnd r) {
+    return r == GameEndDetector::WhiteWin ? "1-0"
+         : r == GameEndDetector::BlackWin ? "0-1"
+         : r == GameEndDetector::Draw     ? "draw"
+                                          : "-";
+}
+
+}
+
+// Plies and nodes to convert won endings with and without the endgame
+// evaluators of the material table
+int endgame(const std::vector<std::string>& args) {
+    int depth    = args.size() > 0 ? std::stoi(args[0]) : 6;
+    int maxPlies = args.size() > 1 ? std::stoi(args[1]) : 200;
+
+    bool enabled = endgames_enabled();
+    std::cout << std::setw(4) << "#" << std::setw(10) << "endgames" << std::setw(8) << "plies"
+              << std::setw(14) << "nodes" << std::setw(8) << "result" << std::endl;
+    for (bool on : {false, true})
+    {
+        set_endgames(on);
+        int      totalPlies = 0;
+        uint64_t totalNodes = 0;
+        for (size_t i = 0; i < endgames.size(); ++i)
+        {
+            Conversion c = play_out(endgames[i], depth, maxPlies);
+            totalPlies += c.plies;
+            totalNodes += c.nodes;
+            std::cout << std::setw(4) << i << std::setw(10) << (on ? "on" : "off") << std::setw(8)
+                      << c.plies << std::setw(14) << c.nodes << std::setw(8)
+                      << result_name(c.result) << std::endl;
+        }
+        std::cout << "endgames " << (on ? "on" : "off") << ": plies " << totalPlies
+                  << ", nodes " << totalNodes << std::endl;
+    }
+    set_endgames(enabled);
+    return 0;
+}
+
+}
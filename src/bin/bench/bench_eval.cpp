@@ -0,0 +1,89 @@
+#include <iomanip>
+#include <iostream>
+
+#include "bench.h"
+#include "evaluate.h"
+#include "helper.h"
+#include "movegen.h"
+#include "pesto_evaluate.h"
+#include "stockfish_position.h"
+
+using namespace Stockfish;
+
+namespace bench {
+
+namespace {
+
+// Calls f on every leaf of the legal move tree below pos
+template<typename F>
+uint64_t walk(Position& pos, int depth, F&& f) {
+    if (depth == 0)
+    {
+        f(pos);
+        return 1;
+    }
+    uint64_t  leaves = 0;
+    StateInfo st;
+    for (const auto& m : MoveList<LEGAL>(pos))
+    {
+        pos.do_move(m, st);
+        leaves += walk(pos, depth - 1, f);
+        pos.undo_move(m);
+    }
+    return leaves;
+}
+
+}
+
+// Evaluations per second on the leaves of a depth limited walk from every
+// bench position. The cost of the walk itself is measured with an empty
+// evaluation and taken off. "by value" copies the position and recomputes the
+// PeSTO sums from the board as evaluate() used to.
+int eval(const std::vector<std::string>& args) {
+    int depth = args.size() > 0 ? std::stoi(args[0]) : 3;
+
+    volatile int sink = 0;
+    auto         run  = [&](auto&& f) {
+        uint64_t  leaves = 0;
+        long long us     = timeit_us([&]() {
+            for (auto& bp : bench_positions())
+            {
+                StateInfo st;
+                Position  pos;
+                pos.set(bp.fen, &st, bp.shatranj);
+                leaves += walk(pos, depth, f);
+            }
+        });
+        return std::make_pair(leaves, us);
+    };
+
+    auto [leaves, walkUs] = run([&](const Position&) { sink = sink + 1; });
+
+    auto report = [&](const char* name, long long us) {
+        long long evalUs = std::max(us - walkUs, 1LL);
+        std::cout << std::setw(24) << name << std::setw(12) << evalUs / 1000 << std::setw(14)
+                  << leaves * 1000000 / evalUs / 1000 << std::endl;
+    };
+
+    std::cout << "leaves: " << leaves << ", walk_ms: " << walkUs / 1000 << std::endl;
+    std::cout << std::setw(24) << "eval" << std::setw(12) << "time_ms" << std::setw(14)
+              << "kevals/s" << std::endl;
+    report("pesto incremental",
+           run([&](const Position& pos) { sink = sink + eval_PeSTO(pos); }).second);
+    report("pesto full",
+           run([&](const Position& pos) { sink = sink + eval_PeSTO_full(pos); }).second);
+    report("evaluate",
+           run([&](const Position& pos) { sink = sink + evaluate(pos); }).second);
+    bool mobility = mobility_enabled();
+    set_mobility(!mobility);
+    report(mobility ? "evaluate no mobility" : "evaluate mobility",
+           run([&](const Position& pos) { sink = sink + evaluate(pos); }).second);
+    set_mobility(mobility);
+    report("evaluate by value", run([&](const Position& pos) {
+               Position copy = pos;
+               sink = sink + int(MoveList<LEGAL>(copy).size()) + eval_PeSTO_full(copy);
+           }).second);
+    return 0;
+}
+
+}
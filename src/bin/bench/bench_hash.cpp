@@ -0,0 +1,122 @@
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#include "bench.h"
+#include "custom_search.h"
+#include "helper.h"
+#include "stockfish_position.h"
+#include "tt.h"
+
+using namespace Stockfish;
+
+namespace bench {
+
+// Time to clear a TT of size_mb, and to grow it to twice the size and shrink
+// it back while keeping the entries, for 1..max_threads threads. Then the
+// nodes of a search after such a resize against a cold and an untouched warm
+// table, which shows what the rehash keeps.
+int hash(const std::vector<std::string>& args) {
+    size_t mbSize     = args.size() > 0 ? std::stoul(args[0]) : 1024;
+    size_t maxThreads = args.size() > 1 ? std::stoul(args[1])
+                                        : std::max(1u, std::thread::hardware_concurrency());
+    int    depth      = args.size() > 2 ? std::stoi(args[2]) : 9;
+
+    TranspositionTable tt;
+    tt.resize(mbSize);
+
+    std::cout << std::setw(8) << "threads" << std::setw(12) << "clear_ms" << std::setw(12)
+              << "grow_ms" << std::setw(12) << "shrink_ms" << std::endl;
+    for (size_t threadCount = 1; threadCount <= maxThreads; threadCount *= 2)
+    {
+        long long clearUs  = timeit_us([&]() { tt.clear(threadCount); });
+        long long growUs   = timeit_us([&]() { tt.resize(mbSize * 2, threadCount, true); });
+        long long shrinkUs = timeit_us([&]() { tt.resize(mbSize, threadCount, true); });
+        std::cout << std::setw(8) << threadCount << std::setw(12) << clearUs / 1000
+                  << std::setw(12) << growUs / 1000 << std::setw(12) << shrinkUs / 1000
+                  << std::endl;
+    }
+
+    auto& bp = bench_positions()[0];
+    auto  nodes = [&](const char* label) {
+        StateInfo st;
+        Position  pos;
+        pos.set(bp.fen, &st, bp.shatranj);
+        Stockfish::search<false> s(&tt, pos);
+        s.iterative_deepening(depth);
+        std::cout << std::setw(18) << label << std::setw(12) << s.nodes_searched() << std::endl;
+    };
+
+    tt.resize(16);
+    nodes("cold");
+    nodes("warm");
+    tt.resize(64, maxThreads, true);
+    nodes("grown 16->64 MB");
+    tt.resize(16);
+    nodes("cold");
+    tt.resize(4, maxThreads, true);
+    nodes("shrunk 16->4 MB");
+    return 0;
+}
+
+// Time-to-depth over the bench positions from a cold TT, and again from a TT
+// loaded from the snapshot the cold search left behind, the way a repeated
+// fencalc --save-tt/--load-tt analysis runs. The load maps the file, its
+// pages come in during the warm search and are counted there.
+int snapshot(const std::vector<std::string>& args) {
+    int         depth  = args.size() > 0 ? std::stoi(args[0]) : 9;
+    size_t      ttSize = args.size() > 1 ? std::stoul(args[1]) : 64;
+    std::string path   = args.size() > 2
+                         ? args[2]
+                         : (std::filesystem::temp_directory_path() / "shatranj_bench.tt").string();
+
+    std::cout << std::setw(4) << "#" << std::setw(12) << "cold_ms" << std::setw(12) << "save_ms"
+              << std::setw(12) << "load_us" << std::setw(12) << "warm_ms" << std::setw(12)
+              << "cold_nodes" << std::setw(12) << "warm_nodes" << std::endl;
+    long long coldTotal = 0, warmTotal = 0;
+    for (size_t i = 0; i < bench_positions().size(); ++i)
+    {
+        auto& bp     = bench_positions()[i];
+        auto  search = [&](TranspositionTable& tt, uint64_t& nodes) {
+            StateInfo st;
+            Position  pos;
+            pos.set(bp.fen, &st, bp.shatranj);
+            Stockfish::search<false> s(&tt, pos);
+            long long                us = timeit_us([&]() { s.iterative_deepening(depth); });
+            nodes                       = s.nodes_searched();
+            return us;
+        };
+
+        uint64_t           coldNodes = 0, warmNodes = 0;
+        TranspositionTable cold;
+        cold.resize(ttSize);
+        long long coldUs = search(cold, coldNodes);
+        bool      saved  = false;
+        long long saveUs = timeit_us([&]() { saved = cold.save(path); });
+
+        TranspositionTable warm;
+        bool               loaded = false;
+        long long          loadUs = timeit_us([&]() { loaded = saved && warm.load(path); });
+        if (!loaded)
+        {
+            std::cout << "could not save or load " << path << std::endl;
+            return 1;
+        }
+        long long warmUs = search(warm, warmNodes);
+        coldTotal += coldUs;
+        warmTotal += warmUs;
+
+        std::cout << std::setw(4) << i << std::setw(12) << coldUs / 1000 << std::setw(12)
+                  << saveUs / 1000 << std::setw(12) << loadUs << std::setw(12) << warmUs / 1000
+                  << std::setw(12) << coldNodes << std::setw(12) << warmNodes << std::endl;
+    }
+    std::remove(path.c_str());
+    std::cout << "cold time_ms: " << coldTotal / 1000 << ", warm time_ms: " << warmTotal / 1000
+              << std::endl;
+    return 0;
+}
+
+}
@@ -0,0 +1,71 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#include "bench.h"
+#include "custom_search.h"
+#include "helper.h"
+#include "stockfish_position.h"
+#include "tt.h"
+
+using namespace Stockfish;
+
+namespace bench {
+
+// Latency of the search worker on the start position. A timed search should
+// return within a few ms of its deadline, and stop() should end an unbounded
+// search in well under 5 ms. One search object is reused for all the runs.
+int latency(const std::vector<std::string>& args) {
+    int movetimeMs = args.size() > 0 ? std::stoi(args[0]) : 100;
+    int runs       = args.size() > 1 ? std::stoi(args[1]) : 10;
+
+    constexpr int Unbounded = 100;
+
+    TranspositionTable tt;
+    tt.resize(64);
+    StateInfo st;
+    Position  pos;
+    pos.set(bench_positions()[0].fen, &st, bench_positions()[0].shatranj);
+
+    long long totalOvershoot = 0, maxOvershoot = 0;
+    {
+        search<true> s(&tt, pos, std::chrono::milliseconds(movetimeMs));
+        for (int i = 0; i < runs; ++i)
+        {
+            tt.clear();
+            long long us        = timeit_us([&]() { s.iterative_deepening(Unbounded); });
+            long long overshoot = us - movetimeMs * 1000LL;
+            totalOvershoot += overshoot;
+            maxOvershoot = std::max(maxOvershoot, overshoot);
+        }
+    }
+
+    long long totalStop = 0, maxStop = 0;
+    {
+        search<true> s(&tt, pos);
+        for (int i = 0; i < runs; ++i)
+        {
+            tt.clear();
+            s.start_parallel_root(Unbounded);
+            std::this_thread::sleep_for(std::chrono::milliseconds(movetimeMs));
+            long long us = timeit_us([&]() {
+                s.stop();
+                s.block_for_search();
+            });
+            totalStop += us;
+            maxStop = std::max(maxStop, us);
+        }
+    }
+
+    std::cout << std::fixed << std::setprecision(2) << "movetime " << movetimeMs << " ms, "
+              << runs << " runs" << std::endl
+              << "deadline overshoot ms: avg " << totalOvershoot / 1000.0 / runs << ", max "
+              << maxOvershoot / 1000.0 << std::endl
+              << "stop latency ms:       avg " << totalStop / 1000.0 / runs << ", max "
+              << maxStop / 1000.0 << std::endl;
+    return 0;
+}
+
+}
@@ -0,0 +1,48 @@
+#include <iomanip>
+#include <iostream>
+
+#include "bench.h"
+#include "bitboard.h"
+#include "helper.h"
+#include "perft.h"
+#include "stockfish_position.h"
+
+using namespace Stockfish;
+
+namespace bench {
+
+// Move generation speed: perft() to a fixed depth from every bench position.
+// An optional "magic" or "pext" forces the rook attack index.
+int perft(const std::vector<std::string>& args) {
+    int depth = args.size() > 0 ? std::stoi(args[0]) : 4;
+
+    if (args.size() > 1 && !Bitboards::init_rook_attacks(args[1] == "pext"))
+        std::cout << args[1] << " rook attacks are not available here" << std::endl;
+    std::cout << "rook attacks: " << Bitboards::rook_indexing() << std::endl;
+
+    long long totalUs    = 0;
+    long long totalNodes = 0;
+    std::cout << std::setw(4) << "#" << std::setw(14) << "nodes" << std::setw(12) << "time_ms"
+              << std::setw(10) << "mnps" << std::endl;
+    for (size_t i = 0; i < bench_positions().size(); ++i)
+    {
+        auto&     bp = bench_positions()[i];
+        StateInfo st;
+        Position  pos;
+        pos.set(bp.fen, &st, bp.shatranj);
+
+        long long nodes = 0;
+        long long us    = timeit_us([&]() { nodes = ::perft(pos, depth); });
+        totalUs += us;
+        totalNodes += nodes;
+        std::cout << std::setw(4) << i << std::setw(14) << nodes << std::setw(12) << us / 1000
+                  << std::setw(10) << std::fixed << std::setprecision(2)
+                  << double(nodes) / std::max(us, 1LL) << std::endl;
+    }
+    std::cout << "total nodes: " << totalNodes << ", time_ms: " << totalUs / 1000
+              << ", mnps: " << std::fixed << std::setprecision(2)
+              << double(totalNodes) / std::max(totalUs, 1LL) << std::endl;
+    return 0;
+}
+
+}
@@ -0,0 +1,77 @@
+#include <iomanip>
+#include <iostream>
+
+#include "bench.h"
+#include "custom_search.h"
+#include "helper.h"
+#include "stockfish_position.h"
+#include "tt.h"
+
+using namespace Stockfish;
+
+namespace bench {
+
+// Moves the main search move picker had to score per negmax node. A staged
+// picker only scores the stages it reaches, so cutoffs on the TT move or on a
+// good capture save the scoring of the remaining moves. In a build with
+// -DATTACK_STATS also the attacks_by() calls per node, each one a scan over
+// the pieces before the attack map, and the scans the attack map still does
+// (a piece type and color at most once per node).
+int picker(const std::vector<std::string>& args) {
+    int    depth  = args.size() > 0 ? std::stoi(args[0]) : 7;
+    size_t ttSize = args.size() > 1 ? std::stoul(args[1]) : 256;
+
+    TranspositionTable tt;
+    tt.resize(ttSize);
+
+    uint64_t  totalNodes = 0, totalScored = 0;
+    long long totalUs = 0;
+#ifdef ATTACK_STATS
+    uint64_t totalSearched = 0, totalQueries = 0, totalBuilds = 0;
+#endif
+    std::cout << std::setw(4) << "#" << std::setw(14) << "negmax_nodes" << std::setw(14)
+              << "scored" << std::setw(16) << "scored/node";
+#ifdef ATTACK_STATS
+    std::cout << std::setw(16) << "attacks/node" << std::setw(14) << "scans/node";
+#endif
+    std::cout << std::endl;
+    for (size_t i = 0; i < bench_positions().size(); ++i)
+    {
+        auto& bp = bench_positions()[i];
+        tt.clear();
+        StateInfo st;
+        Position  pos;
+        pos.set(bp.fen, &st, bp.shatranj);
+
+        Stockfish::search<false> s(&tt, pos);
+        totalUs += timeit_us([&]() { s.iterative_deepening(depth); });
+        totalNodes += s.negmax_nodes();
+        totalScored += s.scored_moves();
+
+        std::cout << std::setw(4) << i << std::setw(14) << s.negmax_nodes() << std::setw(14)
+                  << s.scored_moves() << std::setw(16) << std::fixed << std::setprecision(2)
+                  << double(s.scored_moves()) / std::max<uint64_t>(s.negmax_nodes(), 1);
+#ifdef ATTACK_STATS
+        double nodes = std::max<uint64_t>(s.nodes_searched(), 1);
+        totalSearched += s.nodes_searched();
+        totalQueries += pos.attack_queries();
+        totalBuilds += pos.attack_builds();
+        std::cout << std::setw(16) << pos.attack_queries() / nodes << std::setw(14)
+                  << pos.attack_builds() / nodes;
+#endif
+        std::cout << std::endl;
+    }
+    std::cout << "total negmax nodes: " << totalNodes << ", scored moves: " << totalScored
+              << ", scored/node: " << std::fixed << std::setprecision(2)
+              << double(totalScored) / std::max<uint64_t>(totalNodes, 1)
+              << ", time_ms: " << totalUs / 1000 << std::endl;
+#ifdef ATTACK_STATS
+    std::cout << "attacks_by calls/node: "
+              << double(totalQueries) / std::max<uint64_t>(totalSearched, 1)
+              << ", piece type scans/node: "
+              << double(totalBuilds) / std::max<uint64_t>(totalSearched, 1) << std::endl;
+#endif
+    return 0;
+}
+
+}
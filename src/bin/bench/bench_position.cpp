@@ -0,0 +1,97 @@
+#include <iomanip>
+#include <iostream>
+
+#include "bench.h"
+#include "helper.h"
+#include "movegen.h"
+#include "shatranc_piece.h"
+#include "shatranj.h"
+#include "stockfish_position.h"
+#include "uci_engine.h"
+
+using namespace Stockfish;
+
+namespace bench {
+
+// A deterministic game of up to plies moves from the start position. Quiet
+// moves are preferred so that material, and with it the game, lasts.
+std::vector<std::string> long_game(int plies) {
+    std::deque<StateInfo> states(1);
+    Position              pos;
+    pos.set(shatranj::UCIEngine::StartFEN, &states.back(), true);
+
+    std::vector<std::string> moves;
+    for (int ply = 0; ply < plies; ++ply)
+    {
+        std::vector<Move> quiets, all;
+        for (auto& m : MoveList<LEGAL>(pos))
+        {
+            all.push_back(m);
+            if (!pos.capture(m))
+                quiets.push_back(m);
+        }
+        const auto& pick = quiets.empty() ? all : quiets;
+        if (pick.empty())
+            break;
+
+        Move m = pick[(ply * 7 + 3) % pick.size()];
+        moves.push_back(shatranj::to_uci(m));
+        states.emplace_back();
+        pos.do_move(m, states.back());
+    }
+    return moves;
+}
+
+// Latency of one "position startpos moves ..." command at the end of a game of
+// the given lengths: the legacy board replaying the game, the bitboard position
+// replaying it from the FEN, and the incremental update from the previous
+// command, which was one move shorter.
+int position(const std::vector<std::string>& args) {
+    std::vector<int> lengths;
+    for (auto& a : args)
+        lengths.push_back(std::stoi(a));
+    if (lengths.empty())
+        lengths = {50, 200, 500};
+
+    shatranj::Piece::InitCapturePerSquareTable();
+    shatranj::Piece::InitMovePerSquareTable();
+
+    constexpr int Runs = 20;
+
+    std::cout << std::setw(8) << "plies" << std::setw(14) << "legacy_us" << std::setw(14)
+              << "replay_us" << std::setw(16) << "incremental_us" << std::endl;
+    for (int plies : lengths)
+    {
+        auto                     game = long_game(plies);
+        std::vector<std::string> previous(game.begin(), game.end() - 1);
+
+        long long legacyUs = timeit_us([&]() {
+            for (int i = 0; i < Runs; ++i)
+            {
+                shatranj::Shatranj legacy;
+                for (auto& m : game)
+                    legacy.Play(m);
+            }
+        });
+
+        shatranj::UCIEngine engine;
+        long long           replayUs = 0, incrementalUs = 0;
+        for (int i = 0; i < Runs; ++i)
+        {
+            engine.set_position(shatranj::UCIEngine::StartFEN, {});
+            replayUs += timeit_us(
+              [&]() { engine.set_position(shatranj::UCIEngine::StartFEN, game); });
+
+            engine.set_position(shatranj::UCIEngine::StartFEN, previous);
+            incrementalUs += timeit_us(
+              [&]() { engine.set_position(shatranj::UCIEngine::StartFEN, game); });
+        }
+
+        std::cout << std::setw(8) << game.size() << std::setw(14) << legacyUs / Runs
+                  << std::setw(14) << replayUs / Runs << std::setw(16) << incrementalUs / Runs
+                  << std::endl;
+    }
+    return 0;
+}
+
+}
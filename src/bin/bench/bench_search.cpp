@@ -0,0 +1,189 @@
+#include <cmath>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+
+#include "bench.h"
+#include "custom_search.h"
+#include "eval_cache.h"
+#include "helper.h"
+#include "movegen.h"
+#include "stockfish_position.h"
+#include "tt.h"
+#include "uci_engine.h"
+
+using namespace Stockfish;
+
+namespace bench {
+
+// Nodes and time to a fixed depth for a single threaded search over the bench
+// positions, starting from a cleared TT and eval cache for each position.
+int search_depth(const std::vector<std::string>& args) {
+    int    depth     = args.size() > 0 ? std::stoi(args[0]) : 7;
+    size_t ttSize    = args.size() > 1 ? std::stoul(args[1]) : 256;
+    size_t evalCache = args.size() > 2 ? std::stoul(args[2]) : EvalCache::DefaultSizeMb;
+
+    TranspositionTable tt;
+    tt.resize(ttSize);
+    EvalCache ec;
+    ec.resize(evalCache);
+
+    std::cout << "rook attacks: " << Bitboards::rook_indexing() << std::endl;
+
+    long long totalUs     = 0;
+    uint64_t  totalNodes  = 0;
+    uint64_t  totalQNodes = 0;
+    uint64_t  pawnProbes  = 0;
+    uint64_t  pawnHits    = 0;
+    uint64_t  matProbes   = 0;
+    uint64_t  matHits     = 0;
+    uint64_t  ecProbes    = 0;
+    uint64_t  ecHits      = 0;
+    uint64_t  ttProbes    = 0;
+    uint64_t  ttHits      = 0;
+    std::cout << std::setw(4) << "#" << std::setw(8) << "depth" << std::setw(14) << "nodes"
+              << std::setw(14) << "qnodes" << std::setw(12) << "time_ms" << "  move" << std::endl;
+    for (size_t i = 0; i < bench_positions().size(); ++i)
+    {
+        auto& bp = bench_positions()[i];
+        tt.clear();
+        ec.clear();
+        StateInfo st;
+        Position  pos;
+        pos.set(bp.fen, &st, bp.shatranj);
+
+        Stockfish::search<false> s(&tt, pos);
+        s.set_eval_cache(&ec);
+        Move                     m  = Move::none();
+        long long                us = timeit_us([&]() { m = s.iterative_deepening(depth); });
+        totalUs += us;
+        totalNodes += s.nodes_searched();
+        totalQNodes += s.qsearch_nodes();
+        pawnProbes += s.pawns_table().probes();
+        pawnHits += s.pawns_table().hits();
+        matProbes += s.material_table().probes();
+        matHits += s.material_table().hits();
+        ecProbes += s.eval_cache_probes();
+        ecHits += s.eval_cache_hits();
+        ttProbes += s.tt_probes();
+        ttHits += s.tt_hits();
+
+        std::cout << std::setw(4) << i << std::setw(8) << s.completedDepth << std::setw(14)
+                  << s.nodes_searched() << std::setw(14) << s.qsearch_nodes() << std::setw(12)
+                  << us / 1000 << "  " << m << std::endl;
+    }
+    std::cout << "total nodes: " << totalNodes << ", qsearch nodes: " << totalQNodes
+              << ", time_ms: " << totalUs / 1000
+              << ", knps: " << totalNodes * 1000 / std::max(totalUs, 1LL) << std::endl;
+    std::cout << "pawn hash probes: " << pawnProbes << ", hit rate: " << std::fixed
+              << std::setprecision(1) << 100.0 * pawnHits / std::max<uint64_t>(pawnProbes, 1)
+              << "%" << std::endl;
+    std::cout << "material hash probes: " << matProbes << ", hit rate: " << std::fixed
+              << std::setprecision(1) << 100.0 * matHits / std::max<uint64_t>(matProbes, 1)
+              << "%" << std::endl;
+    std::cout << "eval cache probes: " << ecProbes << ", hit rate: " << std::fixed
+              << std::setprecision(1) << 100.0 * ecHits / std::max<uint64_t>(ecProbes, 1) << "%"
+              << std::endl;
+    std::cout << "tt probes: " << ttProbes << ", hit rate: " << std::fixed << std::setprecision(1)
+              << 100.0 * ttHits / std::max<uint64_t>(ttProbes, 1) << "%" << std::endl;
+    return 0;
+}
+
+// A search to a fixed depth after every move of long_game(), the way a GUI
+// drives the engine through a game: one search object and one TT for the
+// whole game, never cleared, so every search starts on the entries of the
+// previous ones.
+int replay(const std::vector<std::string>& args) {
+    int    plies  = args.size() > 0 ? std::stoi(args[0]) : 60;
+    int    depth  = args.size() > 1 ? std::stoi(args[1]) : 7;
+    size_t ttSize = args.size() > 2 ? std::stoul(args[2]) : 16;
+
+    TranspositionTable tt;
+    tt.resize(ttSize);
+    EvalCache ec;
+    ec.resize(EvalCache::DefaultSizeMb);
+
+    std::deque<StateInfo> states(1);
+    Position              pos;
+    pos.set(shatranj::UCIEngine::StartFEN, &states.back(), true);
+
+    Stockfish::search<false> s(&tt, pos);
+    s.set_eval_cache(&ec);
+
+    long long totalUs    = 0;
+    uint64_t  totalNodes = 0;
+    uint64_t  ttProbes   = 0;
+    uint64_t  ttHits     = 0;
+    std::cout << std::setw(6) << "ply" << std::setw(14) << "nodes" << std::setw(12) << "time_ms"
+              << std::setw(10) << "tt_hit%" << std::setw(10) << "hashfull" << std::endl;
+    auto game = long_game(plies);
+    for (size_t ply = 0; ply <= game.size(); ++ply)
+    {
+        if (MoveList<LEGAL>(pos).size() == 0)
+            break;
+
+        long long us = timeit_us([&]() { s.iterative_deepening(depth); });
+        totalUs += us;
+        totalNodes += s.nodes_searched();
+        ttProbes += s.tt_probes();
+        ttHits += s.tt_hits();
+
+        if (ply % 10 == 0 || ply == game.size())
+            std::cout << std::setw(6) << ply << std::setw(14) << s.nodes_searched()
+                      << std::setw(12) << us / 1000 << std::setw(10) << std::fixed
+                      << std::setprecision(1)
+                      << 100.0 * s.tt_hits() / std::max<uint64_t>(s.tt_probes(), 1)
+                      << std::setw(10) << tt.hashfull() << std::endl;
+
+        if (ply == game.size())
+            break;
+        states.emplace_back();
+        pos.do_move(shatranj::to_move(pos, game[ply]), states.back());
+    }
+    std::cout << "total nodes: " << totalNodes << ", time_ms: " << totalUs / 1000
+              << ", knps: " << totalNodes * 1000 / std::max(totalUs, 1LL) << std::endl;
+    std::cout << "tt probes: " << ttProbes << ", hit rate: " << std::fixed << std::setprecision(1)
+              << 100.0 * ttHits / std::max<uint64_t>(ttProbes, 1) << "%"
+              << ", hashfull: " << tt.hashfull() << std::endl;
+    return 0;
+}
+
+// Effective branching factor: total nodes over the bench positions for every
+// depth up to max_depth, each from a cleared TT, and the ratio to the previous
+// depth.
+int ebf(const std::vector<std::string>& args) {
+    int    maxDepth = args.size() > 0 ? std::stoi(args[0]) : 8;
+    size_t ttSize   = args.size() > 1 ? std::stoul(args[1]) : 256;
+
+    TranspositionTable tt;
+    tt.resize(ttSize);
+
+    uint64_t prevNodes = 0, nodes = 0;
+    std::cout << std::setw(6) << "depth" << std::setw(14) << "nodes" << std::setw(12) << "time_ms"
+              << std::setw(8) << "ebf" << std::endl;
+    for (int depth = 1; depth <= maxDepth; ++depth)
+    {
+        long long totalUs = 0;
+        nodes             = 0;
+        for (auto& bp : bench_positions())
+        {
+            tt.clear();
+            StateInfo st;
+            Position  pos;
+            pos.set(bp.fen, &st, bp.shatranj);
+
+            Stockfish::search<false> s(&tt, pos);
+            totalUs += timeit_us([&]() { s.iterative_deepening(depth); });
+            nodes += s.nodes_searched();
+        }
+        std::cout << std::setw(6) << depth << std::setw(14) << nodes << std::setw(12)
+                  << totalUs / 1000 << std::setw(8) << std::fixed << std::setprecision(2)
+                  << (prevNodes ? double(nodes) / prevNodes : 0.0) << std::endl;
+        prevNodes = nodes;
+    }
+    std::cout << "mean ebf (nodes^(1/depth)): " << std::fixed << std::setprecision(2)
+              << std::pow(double(nodes) / bench_positions().size(), 1.0 / maxDepth) << std::endl;
+    return 0;
+}
+
+}
@@ -0,0 +1,58 @@
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#include "bench.h"
+#include "helper.h"
+#include "lazy_smp_search.h"
+#include "stockfish_position.h"
+#include "tt.h"
+
+using namespace Stockfish;
+
+namespace bench {
+
+// Time-to-depth of the lazy SMP search for 1..max_threads threads over the
+// bench positions. The TT is cleared before every position so that every run
+// starts cold.
+int threads(const std::vector<std::string>& args) {
+    size_t maxThreads = args.size() > 0 ? std::stoul(args[0])
+                                        : std::max(1u, std::thread::hardware_concurrency());
+    int    depth      = args.size() > 1 ? std::stoi(args[1]) : 7;
+    size_t ttSize     = args.size() > 2 ? std::stoul(args[2]) : 256;
+
+    TranspositionTable tt;
+    tt.resize(ttSize);
+
+    long long baseline = 0;
+    std::cout << std::setw(8) << "threads" << std::setw(14) << "time_ms" << std::setw(14)
+              << "nodes" << std::setw(12) << "knps" << std::setw(10) << "speedup" << std::endl;
+    for (size_t threadCount = 1; threadCount <= maxThreads; ++threadCount)
+    {
+        long long totalUs    = 0;
+        uint64_t  totalNodes = 0;
+        for (auto& bp : bench_positions())
+        {
+            tt.clear();
+            StateInfo st;
+            Position  pos;
+            pos.set(bp.fen, &st, bp.shatranj);
+
+            lazy_smp_search<false> s(&tt, pos, threadCount);
+            totalUs += timeit_us([&]() { s.iterative_deepening(depth); });
+            totalNodes += s.nodes_searched();
+        }
+        if (threadCount == 1)
+            baseline = totalUs;
+
+        std::cout << std::setw(8) << threadCount << std::setw(14) << totalUs / 1000
+                  << std::setw(14) << totalNodes << std::setw(12)
+                  << totalNodes * 1000 / std::max(totalUs, 1LL) << std::setw(10) << std::fixed
+                  << std::setprecision(2) << double(baseline) / std::max(totalUs, 1LL)
+                  << std::endl;
+    }
+    return 0;
+}
+
+}
@@ -0,0 +1,83 @@
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "bitboard.h"
+#include "stockfish_position.h"
+
+namespace bench {
+
+// Middlegame and endgame positions, mostly taken from the test puzzles.
+const std::vector<BenchPosition>& bench_positions() {
+    static const std::vector<BenchPosition> positions = {
+      {"rhfvsfhr/pppppppp/8/8/8/8/PPPPPPPP/RHFVSFHR w 0 1", true},
+      {"1r1r4/8/1h6/2p5/2P5/1HS5/R3R3/1s6 b 0 10", true},
+      {"1r4s1/8/5PP1/S1h5/6HR/7F/1r6/7R w 0 10", true},
+      {"3k3r/pp1r3p/8/8/6n1/8/2PPP3/2NKRR2 b - - 0 1", false},
+      {"k6r/8/3B4/6P1/4n3/2P5/1K3R2/8 b - - 0 1", false},
+      {"r3k3/8/1b6/3N4/8/8/8/4K3 w - - 0 1", false},
+      {"2rrnb2/8/bRp1pppp/k1n5/p1P3p1/P1KQB1PP/1RNPN3/5B2 b - - 0 1", false},
+      {"1n1r4/2kP3P/1ppNb1Pb/P1PqP3/3P2R1/1pnBB1R1/r5Q1/2K5 w - - 0 1", false},
+    };
+    return positions;
+}
+
+}
+
+int main(int argc, char** argv) {
+    const std::map<std::string, std::function<int(const std::vector<std::string>&)>> commands = {
+      {"threads", bench::threads},
+      {"search", bench::search_depth},
+      {"replay", bench::replay},
+      {"ebf", bench::ebf},
+      {"picker", bench::picker},
+      {"latency", bench::latency},
+      {"clock", bench::clock},
+      {"position", bench::position},
+      {"eval", bench::eval},
+      {"endgame", bench::endgame},
+      {"perft", bench::perft},
+      {"hash", bench::hash},
+      {"snapshot", bench::snapshot},
+    };
+
+    if (argc < 2 || !commands.contains(argv[1]))
+    {
+        std::cout << "usage: shatranj_bench <command> [args...]" << std::endl;
+        std::cout << "commands:" << std::endl;
+        std::cout << "  threads [max_threads] [depth] [ttsize_mb]  time-to-depth speedup"
+                  << std::endl;
+        std::cout << "  search [depth] [ttsize_mb]                 nodes and time to depth"
+                  << std::endl;
+        std::cout << "  replay [plies] [depth] [ttsize_mb]         TT reuse over a game"
+                  << std::endl;
+        std::cout << "  ebf [max_depth] [ttsize_mb]                effective branching factor"
+                  << std::endl;
+        std::cout << "  picker [depth] [ttsize_mb]                 scored moves per node"
+                  << std::endl;
+        std::cout << "  latency [movetime_ms] [runs]               deadline and stop latency"
+                  << std::endl;
+        std::cout << "  clock [time_ms] [inc_ms] [movestogo]       time manager clock usage"
+                  << std::endl;
+        std::cout << "  position [plies...]                        position command latency"
+                  << std::endl;
+        std::cout << "  eval [depth]                               evaluations per second"
+                  << std::endl;
+        std::cout << "  endgame [depth] [max_plies]                won ending conversion"
+                  << std::endl;
+        std::cout << "  perft [depth] [magic|pext]                 move generation speed"
+                  << std::endl;
+        std::cout << "  hash [size_mb] [max_threads] [depth]       TT clear and resize"
+                  << std::endl;
+        std::cout << "  snapshot [depth] [ttsize_mb] [file]        warm vs cold TT from a file"
+                  << std::endl;
+        return 1;
+    }
+
+    Stockfish::Bitboards::init();
+
+    return commands.at(argv[1])(std::vector<std::string>(argv + 2, argv + argc));
+}
@@ -1,43 +1,68 @@
 #include <chrono>
 #include <iostream>
+#include <string>
 #include <sys/select.h>
+#include <vector>
 
 #include "stockfish_position.h"
 #include "custom_search.h"
+#include "lazy_smp_search.h"
 #include "time.h"
 unsigned int hash3(unsigned int h1, unsigned int h2, unsigned int h3) {
     return (((h1 * 2654435789U) + h2) * 2654435789U) + h3;
 }
 int main(int argc, char** argv) {
-    if (argc < 3)
+    // --load-tt and --save-tt may come anywhere, the rest is positional
+    std::vector<std::string> args;
+    std::string              loadTT, saveTT;
+    for (int a = 1; a < argc; ++a)
     {
-        std::cout << "usage: fencalc <depth> <ttsize_mb> <timeout_s> \"<fen>\"" << std::endl;
-        std::cout << "example: fencalc 4 2048 \"8/8/8/1k6/8/1KQ5/8/q7 w - - 0 1\"" << std::endl;
+        std::string arg = argv[a];
+        if ((arg == "--load-tt" || arg == "--save-tt") && a + 1 < argc)
+            (arg == "--load-tt" ? loadTT : saveTT) = argv[++a];
+        else
+            args.push_back(arg);
+    }
+
+    if (args.size() < 4)
+    {
+        std::cout << "usage: fencalc <depth> <ttsize_mb> <timeout_s> \"<fen>\" [threads]"
+                     " [--load-tt <file>] [--save-tt <file>]"
+                  << std::endl;
+        std::cout << "example: fencalc 4 2048 10 \"8/8/8/1k6/8/1KQ5/8/q7 w - - 0 1\" 8"
+                  << std::endl;
+        std::cout << "--load-tt starts from a saved TT, which brings its own size, and"
+                     " --save-tt writes the TT after the search"
+                  << std::endl;
         return 1;
     }
 
-    shatranj::Piece::InitCapturePerSquareTable();
-    shatranj::Piece::InitMovePerSquareTable();
     Bitboards::init();
-    Position::init();
 
     Stockfish::TranspositionTable tt;
     size_t                        i              = 0;
-    std::string                   depth          = argv[++i];
-    std::string                   ttsize         = argv[++i];
-    std::string                   timeout_s      = argv[++i];
-    std::string                   fen            = argv[++i];
+    std::string                   depth          = args[i++];
+    std::string                   ttsize         = args[i++];
+    std::string                   timeout_s      = args[i++];
+    std::string                   fen            = args[i++];
+    size_t                        threads        = args.size() > 4 ? std::stoul(args[i++]) : 1;
     long                          depth_int      = std::stol(depth);
     long                          ttsize_int     = std::stol(ttsize);
     long                          timeout_s_long = std::stol(timeout_s);
     std::chrono::seconds          timeout(timeout_s_long);
-    tt.resize(ttsize_int);
+    if (loadTT.empty() || !tt.load(loadTT))
+    {
+        if (!loadTT.empty())
+            std::cerr << "could not load " << loadTT << ", starting from an empty TT" << std::endl;
+        tt.resize(ttsize_int, threads);
+    }
     Stockfish::StateInfo st;
     Stockfish::Position  pos;
     pos.set(fen, &st, true);
-    search s1(&tt, pos, timeout);
+    lazy_smp_search s1(&tt, pos, std::max<size_t>(threads, 1), timeout);
     s1.iterative_deepening(depth_int);
     int movecount = Stockfish::MoveList<Stockfish::LEGAL>(pos).size();
+    pos.set_legal_moves(movecount);
     if (movecount == 0)
     {
         auto winner = pos.gameEndDetector.Analyse(pos);
@@ -58,7 +83,14 @@ int main(int argc, char** argv) {
         return 0;
     }
     std::cout << "last completed search depth : " << s1.completedDepth
-              << ", total movecount : " << movecount << std::endl;
+              << ", total movecount : " << movecount << ", threads : " << s1.thread_count()
+              << ", nodes : " << s1.nodes_searched() << ", hashfull : " << tt.hashfull()
+              << std::endl;
     std::cout << s1.picked_move() << std::endl;
+    if (!saveTT.empty() && !tt.save(saveTT))
+    {
+        std::cerr << "could not save " << saveTT << std::endl;
+        return 1;
+    }
     return 0;
 }
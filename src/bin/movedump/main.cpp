@@ -2,7 +2,6 @@
 #include "stockfish_position.h"
 #include "movegen.h"
 #include "bitboard.h"
-#include "shatranc_piece.h"
 
 int main(int argc, char** argv) {
     if (argc < 2) {
@@ -11,11 +10,8 @@ int main(int argc, char** argv) {
         return 1;
     }
 
-    // Initialize required components
-    shatranj::Piece::InitCapturePerSquareTable();
-    shatranj::Piece::InitMovePerSquareTable();
+    // The rook attack table is the only one built at runtime
     Stockfish::Bitboards::init();
-    Stockfish::Position::init();
 
     std::string fen = argv[1];
     
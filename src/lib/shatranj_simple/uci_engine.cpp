@@ -0,0 +1,380 @@
+#include "uci_engine.h"
+#include "../stockfish/custom/evaluate.h"
+#include "../stockfish/misc.h"
+#include "../stockfish/movegen.h"
+#include <algorithm>
+#include <charconv>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+namespace shatranj {
+
+using Stockfish::IO_LOCK;
+using Stockfish::IO_UNLOCK;
+
+namespace {
+
+std::string to_uci_score(Stockfish::Value v) {
+    std::ostringstream ss;
+    if (std::abs(v) >= Stockfish::VALUE_MATE_IN_MAX_PLY) {
+        ss << "mate " << (v > 0 ? Stockfish::VALUE_MATE - v + 1 : -Stockfish::VALUE_MATE - v) / 2;
+    } else {
+        ss << "cp " << v * 100 / Stockfish::PawnValue;
+    }
+    return ss.str();
+}
+
+// The whole token as a number, std::stoul and friends would throw on "abc"
+// and take "12abc" as 12
+template<typename T>
+bool parse_number(const std::string& str, T& value) {
+    T parsed{};
+    auto [end, ec] = std::from_chars(str.data(), str.data() + str.size(), parsed);
+    if (ec != std::errc() || end != str.data() + str.size()) {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+} // namespace
+
+std::string to_uci(Stockfish::Move m) {
+    if (m == Stockfish::Move::none()) {
+        return "(none)";
+    }
+    return std::string(Stockfish::square_to_string(m.from_sq()))
+         + std::string(Stockfish::square_to_string(m.to_sq()));
+}
+
+Stockfish::Move to_move(const Stockfish::Position& pos, const std::string& str) {
+    for (const auto& m : Stockfish::MoveList<Stockfish::LEGAL>(pos)) {
+        if (to_uci(m) == str) {
+            return m;
+        }
+    }
+    return Stockfish::Move::none();
+}
+
+std::vector<std::string> split(const std::string& str) {
+    std::vector<std::string> tokens;
+    std::istringstream iss(str);
+    std::string token;
+    while (iss >> token) {
+        tokens.push_back(token);
+    }
+    return tokens;
+}
+
+UCIEngine::UCIEngine() {
+    Stockfish::Bitboards::init();
+
+    tt_.resize(16);
+    set_position(StartFEN, {});
+    set_threads(1);
+}
+
+UCIEngine::~UCIEngine() {
+    stop();
+    wait();
+}
+
+// Commands are read here while a search runs on the engine's threads, so
+// stop and isready are answered during the search.
+void UCIEngine::run(const std::string& name) {
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        auto tokens = split(line);
+        if (tokens.empty()) continue;
+
+        const std::string& command = tokens[0];
+
+        if (command == "uci") {
+            handle_uci(name);
+        } else if (command == "isready") {
+            sync_cout << "readyok" << sync_endl;
+        } else if (command == "ucinewgame") {
+            new_game();
+        } else if (command == "position") {
+            handle_position(tokens);
+        } else if (command == "go") {
+            handle_go(tokens);
+        } else if (command == "stop") {
+            stop();
+        } else if (command == "setoption") {
+            handle_setoption(tokens);
+        } else if (command == "savehash" || command == "loadhash") {
+            handle_hash_file(tokens);
+        } else if (command == "quit") {
+            stop();
+            wait();
+            return;
+        }
+    }
+    // End of input, let a running search finish and report its move
+    wait();
+}
+
+void UCIEngine::handle_uci(const std::string& name) {
+    sync_cout << "id name " << name << "\n"
+              << "id author ShatranjEngine Team\n"
+              << "option name Hash type spin default 16 min 1 max 1024\n"
+              << "option name Threads type spin default 1 min 1 max "
+              << std::max(1u, std::thread::hardware_concurrency()) << "\n"
+              << "option name Mobility type check default true\n"
+              << "option name EvalCache type spin default " << Stockfish::EvalCache::DefaultSizeMb
+              << " min 0 max 256\n"
+              << "uciok" << sync_endl;
+}
+
+void UCIEngine::new_game() {
+    stop();
+    wait();
+    tt_.clear(threads_);
+    eval_cache_.clear();
+    // A fresh search also starts with empty move ordering statistics
+    set_threads(threads_);
+}
+
+// A GUI repeats the whole game in every position command, usually with one or
+// two moves more than last time. Only the moves after the common prefix with
+// the previous command are undone and played, the StateInfo list keeps the
+// full history for repetition detection.
+bool UCIEngine::set_position(const std::string& fen, const std::vector<std::string>& moves) {
+    stop();
+    wait();
+
+    size_t common = 0;
+    if (fen == fen_) {
+        while (common < moves_.size() && common < moves.size() && moves_[common] == moves[common]) {
+            common++;
+        }
+        while (played_.size() > common) {
+            pos_.undo_move(played_.back());
+            played_.pop_back();
+            moves_.pop_back();
+            states_->pop_back();
+        }
+    } else {
+        auto states = std::make_unique<std::deque<Stockfish::StateInfo>>(1);
+        pos_.set(fen, &states->back(), true);
+        states_ = std::move(states);
+        fen_    = fen;
+        played_.clear();
+        moves_.clear();
+    }
+
+    for (size_t i = common; i < moves.size(); i++) {
+        Stockfish::Move m = to_move(pos_, moves[i]);
+        if (m == Stockfish::Move::none()) {
+            return false;
+        }
+        states_->emplace_back();
+        pos_.do_move(m, states_->back());
+        played_.push_back(m);
+        moves_.push_back(moves[i]);
+    }
+    return true;
+}
+
+void UCIEngine::go(const Stockfish::LimitsType& limits) {
+    stop();
+    wait();
+
+    start_time_ = Stockfish::now();
+    search_->start(limits);
+    reporter_ = std::thread([this]() {
+        Stockfish::Move best = search_->wait();
+        if (uint64_t probes = search_->eval_cache_probes()) {
+            sync_cout << "info string eval cache hit rate "
+                      << search_->eval_cache_hits() * 100 / probes << "% of " << probes
+                      << " probes" << sync_endl;
+        }
+        if (uint64_t probes = search_->tt_probes()) {
+            sync_cout << "info string tt hit rate " << search_->tt_hits() * 100 / probes
+                      << "% of " << probes << " probes, hashfull " << tt_.hashfull() << sync_endl;
+        }
+        sync_cout << "bestmove " << to_uci(best) << sync_endl;
+    });
+}
+
+void UCIEngine::stop() {
+    if (search_) {
+        search_->stop();
+    }
+}
+
+void UCIEngine::wait() {
+    if (reporter_.joinable()) {
+        reporter_.join();
+    }
+}
+
+// Changing the size mid game keeps the analysis: the entries are rehashed into
+// the new table by the search threads' worth of threads
+void UCIEngine::set_hash(size_t mb) {
+    stop();
+    wait();
+    tt_.resize(std::max<size_t>(mb, 1), threads_, true);
+}
+
+void UCIEngine::set_threads(size_t count) {
+    stop();
+    wait();
+    threads_ = std::max<size_t>(count, 1);
+    search_  = std::make_unique<Stockfish::lazy_smp_search<true>>(&tt_, pos_, threads_);
+    search_->set_eval_cache(&eval_cache_);
+    search_->on_iteration([this](Stockfish::Depth depth, const Stockfish::RootMove& best) {
+        send_info(depth, best);
+    });
+}
+
+void UCIEngine::set_mobility(bool enabled) {
+    stop();
+    wait();
+    // The TT and the eval cache keep static evals of the other evaluation
+    if (enabled != Stockfish::mobility_enabled()) {
+        Stockfish::set_mobility(enabled);
+        tt_.clear(threads_);
+        eval_cache_.clear();
+    }
+}
+
+void UCIEngine::set_eval_cache(size_t mb) {
+    stop();
+    wait();
+    eval_cache_.resize(mb);
+    search_->set_eval_cache(&eval_cache_);
+}
+
+bool UCIEngine::save_hash(const std::string& path) {
+    stop();
+    wait();
+    return tt_.save(path);
+}
+
+bool UCIEngine::load_hash(const std::string& path) {
+    stop();
+    wait();
+    return tt_.load(path);
+}
+
+void UCIEngine::handle_setoption(const std::vector<std::string>& tokens) {
+    if (tokens.size() < 5 || tokens[1] != "name" || tokens[3] != "value") {
+        return;
+    }
+    const std::string& name  = tokens[2];
+    const std::string& value = tokens[4];
+
+    size_t number = 0;
+    if (name == "Mobility") {
+        set_mobility(value == "true");
+    } else if (name != "Hash" && name != "Threads" && name != "EvalCache") {
+        return;
+    } else if (!parse_number(value, number)) {
+        sync_cout << "info string invalid value " << value << " for option " << name << sync_endl;
+    } else if (name == "Hash") {
+        set_hash(number);
+    } else if (name == "Threads") {
+        set_threads(number);
+    } else {
+        set_eval_cache(number);
+    }
+}
+
+void UCIEngine::handle_position(const std::vector<std::string>& tokens) {
+    if (tokens.size() < 2) {
+        return;
+    }
+
+    auto moves_it = std::find(tokens.begin(), tokens.end(), "moves");
+    std::vector<std::string> moves;
+    if (moves_it != tokens.end()) {
+        moves.assign(moves_it + 1, tokens.end());
+    }
+
+    std::string fen;
+    if (tokens[1] == "startpos") {
+        fen = StartFEN;
+    } else if (tokens[1] == "fen") {
+        // Parse FEN: position fen <fen_string> moves <move1> <move2> ...
+        for (auto it = tokens.begin() + 2; it != moves_it; ++it) {
+            fen += (fen.empty() ? "" : " ") + *it;
+        }
+    } else {
+        return;
+    }
+
+    if (!set_position(fen, moves)) {
+        sync_cout << "info string illegal move in position command" << sync_endl;
+    }
+}
+
+void UCIEngine::handle_go(const std::vector<std::string>& tokens) {
+    // Parse time controls, no limit at all searches until stop
+    Stockfish::LimitsType limits;
+
+    for (size_t i = 1; i + 1 < tokens.size(); i++) {
+        const std::string& name = tokens[i];
+        auto value = [&](auto& limit) {
+            if (!parse_number(tokens[++i], limit)) {
+                sync_cout << "info string invalid value " << tokens[i] << " for " << name
+                          << sync_endl;
+            }
+        };
+        if (name == "depth") {
+            value(limits.depth);
+        } else if (name == "movetime") {
+            value(limits.movetime);
+        } else if (name == "wtime") {
+            value(limits.time[Stockfish::WHITE]);
+        } else if (name == "btime") {
+            value(limits.time[Stockfish::BLACK]);
+        } else if (name == "winc") {
+            value(limits.inc[Stockfish::WHITE]);
+        } else if (name == "binc") {
+            value(limits.inc[Stockfish::BLACK]);
+        } else if (name == "movestogo") {
+            value(limits.movestogo);
+        }
+    }
+
+    go(limits);
+}
+
+void UCIEngine::handle_hash_file(const std::vector<std::string>& tokens) {
+    if (tokens.size() < 2) {
+        return;
+    }
+
+    std::string path = tokens[1];
+    for (size_t i = 2; i < tokens.size(); i++) {
+        path += " " + tokens[i];
+    }
+
+    bool save = tokens[0] == "savehash";
+    bool ok   = save ? save_hash(path) : load_hash(path);
+    sync_cout << "info string " << (save ? "saving " : "loading ") << path
+              << (ok ? " done" : " failed") << sync_endl;
+}
+
+void UCIEngine::send_info(Stockfish::Depth depth, const Stockfish::RootMove& best) {
+    Stockfish::TimePoint elapsed = std::max<Stockfish::TimePoint>(Stockfish::now() - start_time_, 1);
+    uint64_t nodes = search_->nodes_searched();
+
+    sync_cout << "info depth " << depth
+              << " seldepth " << best.selDepth
+              << " score " << to_uci_score(best.score)
+              << " nodes " << nodes
+              << " nps " << nodes * 1000 / elapsed
+              << " hashfull " << tt_.hashfull()
+              << " time " << elapsed
+              << " pv";
+    for (Stockfish::Move m : best.pv) {
+        std::cout << " " << to_uci(m);
+    }
+    std::cout << sync_endl;
+}
+
+} // namespace shatranj
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "../stockfish/custom/eval_cache.h"
+#include "../stockfish/custom/lazy_smp_search.h"
+#include "../stockfish/custom/timeman.h"
+#include "../stockfish/stockfish_position.h"
+#include "../stockfish/tt.h"
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace shatranj {
+
+// The bitboard search behind both UCI front ends. go() returns at once: the
+// search threads run in the background, print an info line for every
+// completed iteration and finish with bestmove, so the caller keeps reading
+// stdin and can answer isready or stop while the engine thinks.
+class UCIEngine {
+public:
+    static constexpr const char* StartFEN = "rhfvsfhr/pppppppp/8/8/8/8/PPPPPPPP/RHFVSFHR w 0 1";
+
+    UCIEngine();
+    ~UCIEngine();
+
+    // Reads UCI commands from stdin until quit or end of input. The front
+    // ends only differ in the name sent in reply to uci
+    void run(const std::string& name);
+
+    void new_game();
+    // Returns false at the first move that is not legal, the moves before it are kept
+    bool set_position(const std::string& fen, const std::vector<std::string>& moves);
+    void go(const Stockfish::LimitsType& limits);
+    void stop();
+    void wait();
+
+    void set_hash(size_t mb);
+    void set_threads(size_t count);
+    void set_mobility(bool enabled);
+    void set_eval_cache(size_t mb);
+
+    // TT snapshots, a loaded one brings its own size. Both return false on failure
+    bool save_hash(const std::string& path);
+    bool load_hash(const std::string& path);
+
+    // The commands both front ends parse the same way, as split() tokens. A
+    // value that is not a number is reported and ignored, the option or limit
+    // keeps its value
+    void handle_setoption(const std::vector<std::string>& tokens);
+    void handle_position(const std::vector<std::string>& tokens);
+    void handle_go(const std::vector<std::string>& tokens);
+    // Not part of UCI: "savehash <file>" writes a TT snapshot, "loadhash <file>"
+    // replaces the TT with one, for analyses that come back to the same positions
+    void handle_hash_file(const std::vector<std::string>& tokens);
+
+    const Stockfish::Position& position() const { return pos_; }
+
+private:
+    void handle_uci(const std::string& name);
+    void send_info(Stockfish::Depth depth, const Stockfish::RootMove& best);
+
+    Stockfish::TranspositionTable                     tt_;
+    Stockfish::EvalCache                              eval_cache_;
+    Stockfish::StateListPtr                           states_;
+    Stockfish::Position                               pos_;
+    std::string                                       fen_;
+    std::vector<Stockfish::Move>                      played_;
+    std::vector<std::string>                          moves_;
+    size_t                                            threads_ = 1;
+    std::unique_ptr<Stockfish::lazy_smp_search<true>> search_;
+    std::thread                                       reporter_;
+    Stockfish::TimePoint                              start_time_ = 0;
+};
+
+// "e2e4" style coordinates, and the legal move they name or Move::none()
+std::string to_uci(Stockfish::Move m);
+Stockfish::Move to_move(const Stockfish::Position& pos, const std::string& str);
+
+// A command line split at whitespace
+std::vector<std::string> split(const std::string& str);
+
+} // namespace shatranj
@@ -19,35 +19,84 @@
 #include "bitboard.h"
 
 #include <algorithm>
-#include <bitset>
 #include <initializer_list>
-
-#include "misc.h"
+#include <iterator>
+#include <mutex>
 
 namespace Stockfish {
 
-uint8_t PopCnt16[1 << 16];
-uint8_t SquareDistance[SQUARE_NB][SQUARE_NB];
+constexpr std::array<uint8_t, 1 << 16> PopCnt16 = [] {
+    std::array<uint8_t, 1 << 16> t{};
+
+    // A couple of steps per entry, clang stops a constant evaluation after about a million
+    for (unsigned i = 1; i < t.size(); ++i)
+        t[i] = uint8_t(t[i >> 1] + (i & 1));
+    return t;
+}();
+
+constexpr std::array<std::array<uint8_t, SQUARE_NB>, SQUARE_NB> SquareDistance = [] {
+    std::array<std::array<uint8_t, SQUARE_NB>, SQUARE_NB> t{};
+
+    for (int s1 = SQ_A1; s1 <= SQ_H8; ++s1)
+        for (int s2 = SQ_A1; s2 <= SQ_H8; ++s2)
+        {
+            int df = (s1 & 7) - (s2 & 7), dr = (s1 >> 3) - (s2 >> 3);
+            df = df < 0 ? -df : df;
+            dr = dr < 0 ? -dr : dr;
+            t[s1][s2] = uint8_t(df > dr ? df : dr);
+        }
+    return t;
+}();
+
+namespace {
 
-Bitboard LineBB[SQUARE_NB][SQUARE_NB];
-Bitboard BetweenBB[SQUARE_NB][SQUARE_NB];
-Bitboard PseudoAttacks[PIECE_TYPE_NB][SQUARE_NB];
-Bitboard PawnAttacks[COLOR_NB][SQUARE_NB];
+// LineBB and BetweenBB of the squares on the same rank or file, and of the
+// squares an alfil jump apart
+struct Lines {
+    std::array<std::array<Bitboard, SQUARE_NB>, SQUARE_NB> line{}, between{};
+};
+
+constexpr Lines make_lines() {
+    Lines l;
+
+    for (int i = SQ_A1; i <= SQ_H8; ++i)
+        for (int j = SQ_A1; j <= SQ_H8; ++j)
+        {
+            Square s1 = Square(i), s2 = Square(j);
+
+            if (PseudoAttacks[BISHOP][s1] & square_bb(s2))
+            {
+                l.line[s1][s2] =
+                  (PseudoAttacks[BISHOP][s1] & PseudoAttacks[BISHOP][s2]) | square_bb(s1) | square_bb(s2);
+                l.between[s1][s2] = PseudoAttacks[BISHOP][s1] & PseudoAttacks[BISHOP][s2];
+            }
+            if (PseudoAttacks[ROOK][s1] & square_bb(s2))
+            {
+                l.line[s1][s2] =
+                  (PseudoAttacks[ROOK][s1] & PseudoAttacks[ROOK][s2]) | square_bb(s1) | square_bb(s2);
+                l.between[s1][s2] =
+                  sliding_attack(s1, square_bb(s2)) & sliding_attack(s2, square_bb(s1));
+            }
+            l.between[s1][s2] |= square_bb(s2);
+        }
+    return l;
+}
+
+constexpr Lines AllLines = make_lines();
+
+}  // namespace
+
+constexpr std::array<std::array<Bitboard, SQUARE_NB>, SQUARE_NB> LineBB    = AllLines.line;
+constexpr std::array<std::array<Bitboard, SQUARE_NB>, SQUARE_NB> BetweenBB = AllLines.between;
 
 Magic RookMagics[SQUARE_NB];
+bool  UsePext = HasPext;
 
 namespace {
 
 Bitboard RookTable[0x19000];  // To store rook attacks
 
 void init_magics(Bitboard table[], Magic magics[]);
-
-// Returns the bitboard of target square for the given step
-// from the given square. If the step is off the board, returns empty bitboard.
-Bitboard safe_destination(Square s, int step) {
-    Square to = Square(s + step);
-    return is_ok(to) && distance(s, to) <= 2 ? square_bb(to) : Bitboard(0);
-}
 }
 
 // Returns an ASCII representation of a bitboard suitable
@@ -69,88 +118,86 @@ std::string Bitboards::pretty(Bitboard b) {
 }
 
 
-// Initializes various bitboard tables. It is called at
-// startup and relies on global objects to be already zero-initialized.
+// Fills the rook attack table, the only table left that is not built at
+// compile time. Only the first call does the work, so every front end can
+// call it before it needs rook attacks. Pext is used where it is fast: AMD
+// before Zen 3 runs it in microcode, slower than the magic multiply.
 void Bitboards::init() {
 
-    for (unsigned i = 0; i < (1 << 16); ++i)
-        PopCnt16[i] = uint8_t(std::bitset<16>(i).count());
+    static std::once_flag once;
+    std::call_once(once, [] {
+        bool fastPext = HasPext;
+#if defined(USE_PEXT_DISPATCH)
+        __builtin_cpu_init();
+        fastPext = __builtin_cpu_supports("bmi2") && !__builtin_cpu_is("znver1")
+                && !__builtin_cpu_is("znver2");
+#endif
+        init_rook_attacks(fastPext);
+    });
+}
 
-    for (Square s1 = SQ_A1; s1 <= SQ_H8; ++s1)
-        for (Square s2 = SQ_A1; s2 <= SQ_H8; ++s2)
-            SquareDistance[s1][s2] = std::max(distance<File>(s1, s2), distance<Rank>(s1, s2));
+bool Bitboards::init_rook_attacks(bool usePext) {
 
+#if defined(USE_PEXT_DISPATCH)
+    UsePext = usePext && __builtin_cpu_supports("bmi2");
+#endif
+    std::fill(std::begin(RookTable), std::end(RookTable), Bitboard(0));
     init_magics(RookTable, RookMagics);
-
-    for (Square s1 = SQ_A1; s1 <= SQ_H8; ++s1)
-    {
-        PawnAttacks[WHITE][s1] = pawn_attacks_bb<WHITE>(square_bb(s1));
-        PawnAttacks[BLACK][s1] = pawn_attacks_bb<BLACK>(square_bb(s1));
-
-        for (int step : {-9, -8, -7, -1, 1, 7, 8, 9})
-            PseudoAttacks[KING][s1] |= safe_destination(s1, step);
-
-        for (int step : {-17, -15, -10, -6, 6, 10, 15, 17})
-            PseudoAttacks[KNIGHT][s1] |= safe_destination(s1, step);
-
-        for (int step : {-18, -14, 14, 18})
-            PseudoAttacks[BISHOP][s1] |= safe_destination(s1, step);
-
-        for (int step : {-9, -7, 7, 9})
-            PseudoAttacks[QUEEN][s1] |= safe_destination(s1, step);
-
-        PseudoAttacks[ROOK][s1] = attacks_bb<ROOK>(s1, 0);
-
-        for (PieceType pt : {BISHOP, ROOK})
-            for (Square s2 = SQ_A1; s2 <= SQ_H8; ++s2)
-            {
-                if (PseudoAttacks[pt][s1] & s2)
-                {
-                    LineBB[s1][s2] = (attacks_bb(pt, s1, 0) & attacks_bb(pt, s2, 0)) | s1 | s2;
-                    BetweenBB[s1][s2] =
-                      (attacks_bb(pt, s1, square_bb(s2)) & attacks_bb(pt, s2, square_bb(s1)));
-                }
-                BetweenBB[s1][s2] |= s2;
-            }
-    }
+    return UsePext == usePext;
 }
 
-namespace {
-
-Bitboard sliding_attack(Square sq, Bitboard occupied) {
-
-    Bitboard  attacks           = 0;
-    Direction RookDirections[4] = {NORTH, SOUTH, EAST, WEST};
-
-    for (Direction d : RookDirections)
-    {
-        Square s = sq;
-        while (safe_destination(s, d))
-        {
-            attacks |= (s += d);
-            if (occupied & s)
-            {
-                break;
-            }
-        }
-    }
-
-    return attacks;
-}
+const char* Bitboards::rook_indexing() { return UsePext ? "pext" : "magic"; }
 
+namespace {
 
-// Computes all rook and bishop attacks at startup. Magic
-// bitboards are used to look up attacks of sliding pieces. As a reference see
+// The magic numbers init_magics() used to search for at every start, with the
+// PRNG seeds {728, 10316, 55013, 32803, 12281, 15100, 16645, 255} for 64 bit
+// and {8977, 44560, 54343, 38998, 5731, 95205, 104912, 17020} for 32 bit
+// indices. The search always found these, [Is64Bit][square]. Pext indices do
+// not need them.
+constexpr Bitboard RookMagicNumbers[2][SQUARE_NB] = {
+  {0x1100400000808020ULL, 0x1100400000808020ULL, 0x200a10e0800890ULL, 0x10a00c000800410ULL,
+   0x9080084080810404ULL, 0x4081a0481000201ULL, 0x48600480102008a1ULL, 0x8201228080801249ULL,
+   0x100500000440204ULL, 0x1020031000200804ULL, 0x2010802000082008ULL, 0x2010802000082008ULL,
+   0x20500806801a0022ULL, 0x20500806801a0022ULL, 0x38421000a008022ULL, 0x108442002200811ULL,
+   0x8002c02009010202ULL, 0x2041200441100040ULL, 0x2400300100004420ULL, 0x400090210004042ULL,
+   0x580100800080102ULL, 0x3100c0020020202ULL, 0x5020048820101ULL, 0x2491040100000201ULL,
+   0x1080010200424021ULL, 0x3042050080908022ULL, 0x4820802c020212ULL, 0x1010006420000921ULL,
+   0x58cc050008229801ULL, 0x14400200408901ULL, 0xc008104230680104ULL, 0xd00048201380041ULL,
+   0x40105040900823ULL, 0x40105040900823ULL, 0x80220600008610ULL, 0x80502010008289ULL,
+   0x1640040011120008ULL, 0x80048000a41102ULL, 0x40010000028c4aULL, 0x81004000009601ULL,
+   0x20800000049050ULL, 0x2020200802409009ULL, 0x184202200080441ULL, 0x821000800210010ULL,
+   0x302040201006208ULL, 0x400402220054302ULL, 0x4020808200e001ULL, 0x400404030110081ULL,
+   0x40302000900080ULL, 0x60108080c0086941ULL, 0x41010200c002106ULL, 0x801180800810400aULL,
+   0x41010200c002106ULL, 0x890c80401002004ULL, 0x11b0201000104082ULL, 0x180028090800871ULL,
+   0x280006104304013ULL, 0xa1405140040221ULL, 0x2011482520086005ULL, 0x404405290881822ULL,
+   0x12508c220a640482ULL, 0x818211260000402ULL, 0x12008104000a85ULL, 0x20009023018000c1ULL},
+  {0xa80004000801220ULL, 0x8040004010002008ULL, 0x2080200010008008ULL, 0x1100100008210004ULL,
+   0xc200209084020008ULL, 0x2100010004000208ULL, 0x400081000822421ULL, 0x200010422048844ULL,
+   0x800800080400024ULL, 0x1402000401000ULL, 0x3000801000802001ULL, 0x4400800800100083ULL,
+   0x904802402480080ULL, 0x4040800400020080ULL, 0x18808042000100ULL, 0x4040800080004100ULL,
+   0x40048001458024ULL, 0xa0004000205000ULL, 0x3100808010002000ULL, 0x4825010010000820ULL,
+   0x5004808008000401ULL, 0x2024818004000a00ULL, 0x5808002000100ULL, 0x2100060004806104ULL,
+   0x80400880008421ULL, 0x4062220600410280ULL, 0x10a004a00108022ULL, 0x100080080080ULL,
+   0x21000500080010ULL, 0x44000202001008ULL, 0x100400080102ULL, 0xc020128200040545ULL,
+   0x80002000400040ULL, 0x804000802004ULL, 0x120022004080ULL, 0x10a386103001001ULL,
+   0x9010080080800400ULL, 0x8440020080800400ULL, 0x4228824001001ULL, 0x490a000084ULL,
+   0x80002000504000ULL, 0x200020005000c000ULL, 0x12088020420010ULL, 0x10010080080800ULL,
+   0x85001008010004ULL, 0x2000204008080ULL, 0x40413002040008ULL, 0x304081020004ULL,
+   0x80204000800080ULL, 0x3008804000290100ULL, 0x1010100080200080ULL, 0x2008100208028080ULL,
+   0x5000850800910100ULL, 0x8402019004680200ULL, 0x120911028020400ULL, 0x8044010200ULL,
+   0x20850200244012ULL, 0x20850200244012ULL, 0x102001040841ULL, 0x140900040a100021ULL,
+   0x200282410a102ULL, 0x200282410a102ULL, 0x200282410a102ULL, 0x4048240043802106ULL}};
+
+
+// Fills the rook attack table. Magic bitboards are used to look up
+// attacks of sliding pieces. As a reference see
 // www.chessprogramming.org/Magic_Bitboards. In particular, here we use the so
 // called "fancy" approach.
 void init_magics(Bitboard table[], Magic magics[]) {
 
-    // Optimal PRNG seeds to pick the correct magics in the shortest time
-    int seeds[][RANK_NB] = {{8977, 44560, 54343, 38998, 5731, 95205, 104912, 17020},
-                            {728, 10316, 55013, 32803, 12281, 15100, 16645, 255}};
-
-    Bitboard occupancy[4096], reference[4096], edges, b;
-    int      epoch[4096] = {}, cnt = 0, size = 0;
+    Bitboard edges, b;
+    int      size = 0;
 
     for (Square s = SQ_A1; s <= SQ_H8; ++s)
     {
@@ -165,57 +212,24 @@ void init_magics(Bitboard table[], Magic magics[]) {
         Magic& m = magics[s];
         m.mask   = sliding_attack(s, 0) & ~edges;
         m.shift  = (Is64Bit ? 64 : 32) - popcount(m.mask);
+        m.magic  = RookMagicNumbers[Is64Bit][s];
 
         // Set the offset for the attacks table of the square. We have individual
         // table sizes for each square with "Fancy Magic Bitboards".
         m.attacks = s == SQ_A1 ? table : magics[s - 1].attacks + size;
 
         // Use Carry-Rippler trick to enumerate all subsets of masks[s] and
-        // store the corresponding sliding attack bitboard in reference[].
+        // store the corresponding sliding attack bitboard in attacks[].
         b = size = 0;
         do
         {
-            occupancy[size] = b;
-            reference[size] = sliding_attack(s, b);
-
-            if (HasPext)
-                m.attacks[pext(b, m.mask)] = reference[size];
+            Bitboard& entry = m.attacks[m.index(b)];
+            assert(!entry || entry == sliding_attack(s, b));
+            entry = sliding_attack(s, b);
 
             size++;
             b = (b - m.mask) & m.mask;
         } while (b);
-
-        if (HasPext)
-            continue;
-
-        PRNG rng(seeds[Is64Bit][rank_of(s)]);
-
-        // Find a magic for square 's' picking up an (almost) random number
-        // until we find the one that passes the verification test.
-        for (int i = 0; i < size;)
-        {
-            for (m.magic = 0; popcount((m.magic * m.mask) >> 56) < 6;)
-                m.magic = rng.sparse_rand<Bitboard>();
-
-            // A good magic must map every possible occupancy to an index that
-            // looks up the correct sliding attack in the attacks[s] database.
-            // Note that we build up the database for square 's' as a side
-            // effect of verifying the magic. Keep track of the attempt count
-            // and save it in epoch[], little speed-up trick to avoid resetting
-            // m.attacks[] after every failed attempt.
-            for (++cnt, i = 0; i < size; ++i)
-            {
-                unsigned idx = m.index(occupancy[i]);
-
-                if (epoch[idx] < cnt)
-                {
-                    epoch[idx]     = cnt;
-                    m.attacks[idx] = reference[i];
-                }
-                else if (m.attacks[idx] != reference[i])
-                    break;
-            }
-        }
     }
 }
 }
@@ -20,6 +20,7 @@
 #define BITBOARD_H_INCLUDED
 
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <cmath>
 #include <cstdint>
@@ -28,6 +29,10 @@
 
 #include "types.h"
 
+#if defined(USE_AVX2)
+    #include <immintrin.h>
+#endif
+
 namespace Stockfish {
 
 namespace Bitboards {
@@ -35,6 +40,13 @@ namespace Bitboards {
 void        init();
 std::string pretty(Bitboard b);
 
+// Refills the rook attack table for pext or for magic indices. Returns false
+// when this build or CPU can only index the other way, the table is then
+// filled for that one. Not thread safe, no search may run meanwhile.
+bool init_rook_attacks(bool usePext);
+// "pext" or "magic", the rook attack index in use
+const char* rook_indexing();
+
 }  // namespace Stockfish::Bitboards
 
 constexpr Bitboard FileABB = 0x0101010101010101ULL;
@@ -55,14 +67,26 @@ constexpr Bitboard Rank6BB = Rank1BB << (8 * 5);
 constexpr Bitboard Rank7BB = Rank1BB << (8 * 6);
 constexpr Bitboard Rank8BB = Rank1BB << (8 * 7);
 
-extern uint8_t PopCnt16[1 << 16];
-extern uint8_t SquareDistance[SQUARE_NB][SQUARE_NB];
-
-extern Bitboard BetweenBB[SQUARE_NB][SQUARE_NB];
-extern Bitboard LineBB[SQUARE_NB][SQUARE_NB];
-extern Bitboard PseudoAttacks[PIECE_TYPE_NB][SQUARE_NB];
-extern Bitboard PawnAttacks[COLOR_NB][SQUARE_NB];
+// Built at compile time in bitboard.cpp. PseudoAttacks and PawnAttacks are
+// further down, other constant expressions use them.
+extern const std::array<uint8_t, 1 << 16>                                PopCnt16;
+extern const std::array<std::array<uint8_t, SQUARE_NB>, SQUARE_NB>       SquareDistance;
+extern const std::array<std::array<Bitboard, SQUARE_NB>, SQUARE_NB>      BetweenBB;
+extern const std::array<std::array<Bitboard, SQUARE_NB>, SQUARE_NB>      LineBB;
+
+
+#if defined(USE_PEXT_DISPATCH)
+// The pext instruction for a build without -mbmi2, only run once the CPU is
+// known to have it. Inline asm keeps it inlined into every caller.
+inline Bitboard runtime_pext(Bitboard b, Bitboard m) {
+    Bitboard r;
+    asm("pextq %2, %1, %0" : "=r"(r) : "r"(b), "rm"(m));
+    return r;
+}
+#endif
 
+// Set by Bitboards::init() when the rook attacks are indexed with pext
+extern bool UsePext;
 
 // Magic holds all magic bitboards relevant data for a single square
 struct Magic {
@@ -77,6 +101,11 @@ struct Magic {
         if (HasPext)
             return unsigned(pext(occupied, mask));
 
+#if defined(USE_PEXT_DISPATCH)
+        if (UsePext)
+            return unsigned(runtime_pext(occupied, mask));
+#endif
+
         if (Is64Bit)
             return unsigned(((occupied & mask) * magic) >> shift);
 
@@ -142,6 +171,101 @@ constexpr Bitboard shift(Bitboard b) {
 }
 
 
+// File offset of a leaper step of at most two files to either side
+constexpr int step_file(int d) { return (d % 8 + 11) % 8 - 3; }
+
+// The squares a leaper step D starts from without crossing a side of the board
+template<int D>
+constexpr Bitboard jump_from_bb() {
+    constexpr int F = step_file(D);
+    return F == 2  ? ~(FileGBB | FileHBB)
+         : F == 1  ? ~FileHBB
+         : F == -1 ? ~FileABB
+         : F == -2 ? ~(FileABB | FileBBB)
+                   : ~Bitboard(0);
+}
+
+// Moves every square of b by the leaper step D, the squares that would leave
+// the board are dropped
+template<int D>
+constexpr Bitboard jump(Bitboard b) {
+    return D > 0 ? (b & jump_from_bb<D>()) << D : (b & jump_from_bb<D>()) >> -D;
+}
+
+// Only the rook slides in shatranj. Every other piece reaches its squares
+// with a fixed set of steps, so the attacks of all the pieces of a type are
+// a handful of shifts of the whole set, no loop over the pieces.
+template<int... Ds>
+struct LeaperSteps {
+    static constexpr Bitboard attacks(Bitboard b) { return (jump<Ds>(b) | ...); }
+
+#if defined(USE_AVX2)
+    // Four steps per 256 bit register. A lane shifts left for a positive step
+    // and right for a negative one, a count of 64 gives zero in the other.
+    static Bitboard attacks_avx2(Bitboard b) {
+        static_assert(sizeof...(Ds) % 4 == 0);
+        alignas(32) static constexpr uint64_t From[]  = {jump_from_bb<Ds>()...};
+        alignas(32) static constexpr uint64_t Left[]  = {Ds > 0 ? uint64_t(Ds) : uint64_t(64)...};
+        alignas(32) static constexpr uint64_t Right[] = {Ds < 0 ? uint64_t(-Ds) : uint64_t(64)...};
+
+        const __m256i bb  = _mm256_set1_epi64x(int64_t(b));
+        __m256i       acc = _mm256_setzero_si256();
+        for (size_t i = 0; i < sizeof...(Ds); i += 4)
+        {
+            __m256i from  = _mm256_load_si256((const __m256i*) (From + i));
+            __m256i left  = _mm256_load_si256((const __m256i*) (Left + i));
+            __m256i right = _mm256_load_si256((const __m256i*) (Right + i));
+            __m256i x     = _mm256_and_si256(bb, from);
+            acc = _mm256_or_si256(acc, _mm256_sllv_epi64(x, left));
+            acc = _mm256_or_si256(acc, _mm256_srlv_epi64(x, right));
+        }
+        __m128i r = _mm_or_si128(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+        return Bitboard(_mm_cvtsi128_si64(r) | _mm_extract_epi64(r, 1));
+    }
+#endif
+};
+
+// The steps are in ascending order, so the moves of a lone piece generated
+// step by step come in the same square order as from its attack bitboard
+template<PieceType Pt>
+struct Leaper;
+template<>
+struct Leaper<KNIGHT>: LeaperSteps<-17, -15, -10, -6, 6, 10, 15, 17> {};
+template<>
+struct Leaper<BISHOP>: LeaperSteps<-18, -14, 14, 18> {};  // alfil
+template<>
+struct Leaper<QUEEN>: LeaperSteps<-9, -7, 7, 9> {};  // ferz
+template<>
+struct Leaper<KING>: LeaperSteps<-9, -8, -7, -1, 1, 7, 8, 9> {};
+
+// Returns the squares attacked by all the Pt pieces on b
+template<PieceType Pt>
+inline Bitboard leaper_attacks_bb(Bitboard b) {
+#if defined(USE_AVX2)
+    return Leaper<Pt>::attacks_avx2(b);
+#else
+    return Leaper<Pt>::attacks(b);
+#endif
+}
+
+inline Bitboard leaper_attacks_bb(PieceType pt, Bitboard b) {
+
+    assert(pt != PAWN && pt != ROOK);
+
+    switch (pt)
+    {
+    case KNIGHT :
+        return leaper_attacks_bb<KNIGHT>(b);
+    case BISHOP :
+        return leaper_attacks_bb<BISHOP>(b);
+    case QUEEN :
+        return leaper_attacks_bb<QUEEN>(b);
+    default :
+        return leaper_attacks_bb<KING>(b);
+    }
+}
+
+
 // Returns the squares attacked by pawns of the given color
 // from the squares in the given bitboard.
 template<Color C>
@@ -150,6 +274,68 @@ constexpr Bitboard pawn_attacks_bb(Bitboard b) {
                       : shift<SOUTH_WEST>(b) | shift<SOUTH_EAST>(b);
 }
 
+// Returns the bitboard of target square for the given step
+// from the given square. If the step is off the board, returns empty bitboard.
+constexpr Bitboard safe_destination(Square s, int step) {
+    int to = s + step;
+    int df = (to & 7) - file_of(s), dr = (to >> 3) - rank_of(s);
+    return is_ok(Square(to)) && df >= -2 && df <= 2 && dr >= -2 && dr <= 2
+           ? square_bb(Square(to))
+           : Bitboard(0);
+}
+
+// Returns the rook attacks from s, a ray stops at the first occupied square
+constexpr Bitboard sliding_attack(Square s, Bitboard occupied) {
+
+    Bitboard attacks = 0;
+
+    for (Direction d : {NORTH, SOUTH, EAST, WEST})
+        for (Square to = s; safe_destination(to, d);)
+        {
+            to = Square(to + d);
+            attacks |= square_bb(to);
+            if (occupied & square_bb(to))
+                break;
+        }
+
+    return attacks;
+}
+
+inline constexpr auto PseudoAttacks = [] {
+    std::array<std::array<Bitboard, SQUARE_NB>, PIECE_TYPE_NB> t{};
+
+    for (int i = SQ_A1; i <= SQ_H8; ++i)
+    {
+        Square s = Square(i);
+
+        for (int step : {-9, -8, -7, -1, 1, 7, 8, 9})
+            t[KING][s] |= safe_destination(s, step);
+
+        for (int step : {-17, -15, -10, -6, 6, 10, 15, 17})
+            t[KNIGHT][s] |= safe_destination(s, step);
+
+        for (int step : {-18, -14, 14, 18})
+            t[BISHOP][s] |= safe_destination(s, step);
+
+        for (int step : {-9, -7, 7, 9})
+            t[QUEEN][s] |= safe_destination(s, step);
+
+        t[ROOK][s] = sliding_attack(s, 0);
+    }
+    return t;
+}();
+
+inline constexpr auto PawnAttacks = [] {
+    std::array<std::array<Bitboard, SQUARE_NB>, COLOR_NB> t{};
+
+    for (int s = SQ_A1; s <= SQ_H8; ++s)
+    {
+        t[WHITE][s] = pawn_attacks_bb<WHITE>(square_bb(Square(s)));
+        t[BLACK][s] = pawn_attacks_bb<BLACK>(square_bb(Square(s)));
+    }
+    return t;
+}();
+
 inline Bitboard pawn_attacks_bb(Color c, Square s) {
 
     assert(is_ok(s));
@@ -207,6 +393,7 @@ inline int distance<Square>(Square x, Square y) {
 }
 
 inline int edge_distance(File f) { return std::min(f, File(FILE_H - f)); }
+inline int edge_distance(Rank r) { return std::min(r, Rank(RANK_8 - r)); }
 
 // Returns the pseudo attacks of the given piece type
 // assuming an empty board.
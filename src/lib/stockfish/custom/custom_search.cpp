@@ -2,10 +2,93 @@
 #include "custommovepicker.h"
 #include "evaluate.h"
 #include "game_over_check.h"
+#include <array>
 #include <chrono>
+#include <cmath>
 
 namespace Stockfish {
 
+namespace {
+// evaluate() scores a finished game as +-VALUE_MATE. Shift it by the ply so that
+// shorter mates score better and can be stored in the TT.
+Value mate_adjusted(Value v, int ply) {
+    return v == VALUE_MATE ? mate_in(ply) : v == -VALUE_MATE ? mated_in(ply) : v;
+}
+
+// Adjusts a mate score from "plies to mate from the root" to "plies to mate from
+// the current position" before it is stored in the TT.
+Value value_to_tt(Value v, int ply) {
+    return v >= VALUE_MATE_IN_MAX_PLY ? v + ply : v <= VALUE_MATED_IN_MAX_PLY ? v - ply : v;
+}
+
+// Inverse of value_to_tt(). There is no fifty move rule in this engine, so unlike
+// Stockfish there is no need to downgrade mates that rule50 could spoil.
+Value value_from_tt(Value v, int ply) {
+    if (v == VALUE_NONE)
+        return VALUE_NONE;
+
+    return v >= VALUE_MATE_IN_MAX_PLY ? v - ply : v <= VALUE_MATED_IN_MAX_PLY ? v + ply : v;
+}
+
+// Lazy SMP depth skipping: helper threads skip some iterations so that they
+// spread over different depths and fill the shared TT with different subtrees.
+constexpr int SkipSize[]  = {1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+constexpr int SkipPhase[] = {0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
+
+// True if one of the quiet moves is legal, stops at the first one
+bool has_legal_quiet(const Position& pos) {
+    ExtMove  moves[MAX_MOVES];
+    ExtMove* last = generate<QUIETS>(pos, moves);
+    return std::any_of(moves, last, [&](const ExtMove& m) { return pos.legal(m); });
+}
+
+// History bonus (and malus) for a quiet move at the given depth
+int stat_bonus(int depth) { return std::min(170 * depth - 100, 1700); }
+
+// Late move reductions by [depth][moveCount]. The reduction grows with the log
+// of both, so late moves at high depth are searched a few plies shallower.
+const auto Reductions = [] {
+    std::array<std::array<int, 64>, 64> r{};
+    for (int d = 1; d < 64; ++d)
+        for (int mc = 1; mc < 64; ++mc)
+            r[d][mc] = int(std::log(d) * std::log(mc) / 2.25);
+    return r;
+}();
+
+int reduction(int depth, int moveCount) {
+    return Reductions[std::min(depth, 63)][std::min(moveCount, 63)];
+}
+
+// Number of moves after which the remaining quiets are pruned at low depth
+int futility_move_count(bool improving, int depth) {
+    return (3 + depth * depth) / (2 - improving);
+}
+}
+
+// Updates killers, history and countermove after a quiet move caused a beta
+// cutoff. The quiet moves tried before it get the same amount as malus.
+template<bool HaveTimeout>
+void search<HaveTimeout>::update_quiet_stats(
+  Stack* ss, Move bestMove, const Move* quiets, int quietCount, int depth) {
+    if (ss->killers[0] != bestMove)
+    {
+        ss->killers[1] = ss->killers[0];
+        ss->killers[0] = bestMove;
+    }
+
+    Color us    = m_pos.side_to_move();
+    int   bonus = stat_bonus(depth);
+    mainHistory.update(us, bestMove, bonus);
+    for (int i = 0; i < quietCount; ++i)
+        mainHistory.update(us, quiets[i], -bonus);
+
+    if ((ss - 1)->move.is_ok())
+    {
+        Square prevSq                               = (ss - 1)->move.to_sq();
+        counterMoves[m_pos.piece_on(prevSq)][prevSq] = bestMove;
+    }
+}
+
 template<bool HaveTimeout>
 template<SearchRunType nodeType>
 Value search<HaveTimeout>::negmax(Stack* ss, int depth, Value alpha, Value beta, bool cutNode) {
@@ -23,12 +106,18 @@ Value search<HaveTimeout>::negmax(Stack* ss, int depth, Value alpha, Value beta,
         rootrun++;
     }
 
+    if constexpr (HaveTimeout)
+        check_time();
+
     assert(alpha < beta);
     Key            posKey   = m_pos.key();
     constexpr bool PvNode   = nodeType != NonPV;
     constexpr bool rootNode = nodeType == Root;
     depth                   = std::max(depth, 0);
 
+    if (PvNode && selDepth < ss->ply + 1)
+        selDepth = ss->ply + 1;
+
     // Check if we have an upcoming move that draws by repetition
     if (!rootNode && alpha < VALUE_DRAW && m_pos.upcoming_repetition(ss->ply))
     {
@@ -41,35 +130,42 @@ Value search<HaveTimeout>::negmax(Stack* ss, int depth, Value alpha, Value beta,
 
     auto [ttHit, ttData, ttWriter] = m_tt->probe(posKey);
     ss->ttHit                      = ttHit;
+    ++ttProbes;
+    ttHits += ttHit;
+    ttData.move                    = rootNode ? rootMoves[pvIdx].pv[0]
+                                   : ttHit  ? ttData.move
+                                            : Move::none();
+    ttData.value                   = ttHit ? value_from_tt(ttData.value, ss->ply) : VALUE_NONE;
     ss->ttMove                     = ttData.move;
     bool ttCapture                 = ttData.move && m_pos.capture_stage(ttData.move);
-    /*     if (ttHit && ttData.depth >= depth && !PvNode)
+
+    // At non-PV nodes a deep enough entry whose bound covers the window is final
+    if (!PvNode && ttData.depth >= depth && ttData.value != VALUE_NONE
+        && (ttData.bound & (ttData.value >= beta ? BOUND_LOWER : BOUND_UPPER)))
     {
-        return ttData.eval;
-    } */
+        return ttData.value;
+    }
 
-    auto moves = CustomMovePicker(m_pos, m_tt);
+    (ss + 2)->killers[0] = (ss + 2)->killers[1] = Move::none();
 
-    if (moves.size() == 0)
+    if (m_pos.known_game_end() != GameEndDetector::None)
     {
-        Value ret = evaluate(m_pos);
-        ttWriter.write(posKey, VALUE_ZERO, false, Stockfish::BOUND_UPPER, depth, Move::none(), ret,
-                       m_tt->generation());
+        // A finished game is scored by evaluate(), never from the cache
+        Value rawEval = evaluate(m_pos, &pawnsTable, &materialTable);
+        Value ret     = mate_adjusted(rawEval, ss->ply);
+        ttWriter.write(posKey, value_to_tt(ret, ss->ply), PvNode, BOUND_EXACT, depth, Move::none(),
+                       rawEval, m_tt->generation());
         return ret;
     }
 
+    // qnegmax stores its own result under this key
     if (depth == 0)
     {
-        auto res = qnegmax<nodeType>(ss, alpha, beta);
-        /* if (PvNode)  // Update pv even in fail-high case
-                update_pv(ss->pv, m, (ss + 1)->pv); */
-        ttWriter.write(posKey, VALUE_ZERO, false, Stockfish::BOUND_UPPER, depth, Move::none(), res,
-                       m_tt->generation());
-        return res;
+        return qnegmax<nodeType>(ss, alpha, beta, DEPTH_QS_CHECKS);
     }
 
     // futility pruning
-    Value eval             = evaluate(m_pos);
+    Value eval             = ttHit && ttData.eval != VALUE_NONE ? ttData.eval : static_eval();
     ss->staticEval         = eval;
     bool improving         = ss->staticEval > (ss - 2)->staticEval;
     bool opponentWorsening = ss->staticEval + (ss - 1)->staticEval > 2;
@@ -82,15 +178,18 @@ Value search<HaveTimeout>::negmax(Stack* ss, int depth, Value alpha, Value beta,
 
     if (m_pos.checkers() == 0)
     {
+        // Neither shortcut returns before a legal move is known to exist,
+        // stalemate is a loss in shatranj and evaluate() does not look for it.
+        // A stalemated side is left to the move loop below, which scores it
         if ((ss - 1)->move != Move::null() && depth > 3 && eval - futilityMargin >= beta
-            && eval >= beta && (!ttData.move || ttCapture))
+            && eval >= beta && (!ttData.move || ttCapture) && m_pos.has_legal_moves())
         {
             return beta + (eval - beta) / 3;
         }
 
         // maybe noise but slows down 42s to 45s ~ in stockfish_evaluation_function_tests
         // will keep it probably might be usefull for big boards with more pieces
-        if (cutNode && (ss - 1)->move != Move::null() && depth > 3)
+        if (cutNode && (ss - 1)->move != Move::null() && depth > 3 && m_pos.has_legal_moves())
         {
             StateInfo st;
 
@@ -99,50 +198,102 @@ Value search<HaveTimeout>::negmax(Stack* ss, int depth, Value alpha, Value beta,
             ss->move        = Move::none();
             Value nullValue = -negmax<NonPV>(ss + 1, depth - 3, -beta, -beta + 1, false);
             m_pos.undo_null_move();
+            // Do not return unproven mate scores
             if (nullValue >= beta)
             {
-                return nullValue;
+                return nullValue >= VALUE_MATE_IN_MAX_PLY ? beta : nullValue;
             }
         }
     }
 
-    Value value    = -VALUE_INFINITE;
     Value besteval = -VALUE_INFINITE;
     Move  bestmove = Move::none();
 
-    int moveCount = 0;
-    for (auto& m : moves)
+    Move prevMove    = (ss - 1)->move;
+    Move counterMove = prevMove.is_ok()
+                       ? counterMoves[m_pos.piece_on(prevMove.to_sq())][prevMove.to_sq()]
+                       : Move::none();
+
+    CustomMovePicker mp(m_pos, ttData.move, ss->killers, &mainHistory, counterMove);
+    Move             m;
+
+    Move quietsSearched[32];
+    int  quietCount = 0;
+
+    const bool inCheck   = m_pos.checkers();
+    int        moveCount = 0;
+    while ((m = mp.next_move()) != Move::none())
     {
-        if constexpr (HaveTimeout)
+        if (!m_pos.legal(m))
+            continue;
+
+        Value recCalc = -VALUE_INFINITE;
+        moveCount++;
+        bool capture    = m_pos.capture_stage(m);
+        bool givesCheck = m_pos.gives_check(m);
+
+        // Shallow depth pruning, once a move has been searched
+        if (!rootNode && !inCheck && depth <= 4 && besteval > VALUE_MATED_IN_MAX_PLY)
         {
-            if (stopflag)
-                break;
+            // Late move pruning, drop the late quiets
+            if (!PvNode && moveCount >= futility_move_count(improving, depth))
+            {
+                mp.skip_quiet_moves();
+                if (!capture && !givesCheck)
+                    continue;
+            }
+
+            // Quiet moves onto squares where the static exchange loses the piece
+            if (!capture && !givesCheck && !m_pos.see_ge(m, -50 * depth * depth))
+                continue;
         }
-        Value       recCalc = -VALUE_INFINITE;
-        std::string mstr    = MoveToStr(m);
-        (void) mstr;
-        moveCount++;
+
+        // The child's bucket is on its way while do_move() updates the board
+        prefetch(m_tt->first_entry(m_pos.key_after(m)));
+
         StateInfo st;
+        uint64_t  nodeCount = rootNode ? uint64_t(nodes) : 0;
         m_pos.do_move(m, st);
-        uint64_t nodeCount = rootNode ? uint64_t(nodes) : 0;
+        this->nodes.fetch_add(1, std::memory_order_relaxed);
 
         ss->move = m;
-        value    = m.value;
 
-        if (!PvNode || moveCount > 1)  // root node is also non pv node
+        int newDepth = depth - 1;
+
+        // Late move reductions, a reduced null window search for late quiets
+        // and a full depth one if it unexpectedly beats alpha
+        if (depth >= 3 && moveCount > 1 + 2 * PvNode && !capture && !givesCheck && !inCheck)
+        {
+            int r = reduction(depth, moveCount);
+            r += (!improving && r > 1) + cutNode + ttCapture - PvNode;
+            int d = std::clamp(newDepth - r, 1, newDepth);
+
+            recCalc = -negmax<NonPV>(ss + 1, d, -(alpha + 1), -alpha, true);
+            if (recCalc > alpha && d < newDepth)
+                recCalc = -negmax<NonPV>(ss + 1, newDepth, -(alpha + 1), -alpha, !cutNode);
+        }
+        else if (!PvNode || moveCount > 1)  // root node is also non pv node
         {
-            recCalc = -negmax<NonPV>(ss + 1, depth - 1, -(alpha + 1), -alpha, !cutNode);
+            recCalc = -negmax<NonPV>(ss + 1, newDepth, -(alpha + 1), -alpha, !cutNode);
         }
 
         if (PvNode && (moveCount == 1 || recCalc > alpha /* || rootNode */))
         {
             (ss + 1)->pv    = pv;
             (ss + 1)->pv[0] = Move::none();
-            recCalc         = -negmax<PV>(ss + 1, depth - 1, -beta, -alpha, false);
+            recCalc         = -negmax<PV>(ss + 1, newDepth, -beta, -alpha, false);
         }
         m_pos.undo_move(m);
         ss->move = Move::none();
 
+        // A stopped search returns garbage from the subtree; don't let it reach
+        // the root moves or the shared transposition table.
+        if constexpr (HaveTimeout)
+        {
+            if (stopflag)
+                return VALUE_ZERO;
+        }
+
         if (rootNode)
         {
             RootMove& rm = *std::find(rootMoves.begin(), rootMoves.end(), m);
@@ -161,7 +312,8 @@ Value search<HaveTimeout>::negmax(Stack* ss, int depth, Value alpha, Value beta,
                     rmpv.push_back(*mptr);
                 }
                 pv_manager2.insert_or_replace({.move = m, .value = recCalc});
-                rm.score = recCalc;
+                rm.score    = recCalc;
+                rm.selDepth = selDepth;
 
                 if (moveCount > 1)
                     this->bestMoveChanges.fetch_add(1, std::memory_order_relaxed);
@@ -192,39 +344,112 @@ Value search<HaveTimeout>::negmax(Stack* ss, int depth, Value alpha, Value beta,
                 }
             }
         }
+
+        if (m != bestmove && !m_pos.capture_stage(m) && quietCount < 32)
+            quietsSearched[quietCount++] = m;
     }
-    ttWriter.write(posKey, value, false,
+    scoredMoves += mp.scored();
+
+    // The picker went through every move, without a legal one the side to
+    // move has lost (mate or stalemate alike)
+    if (!moveCount)
+    {
+        m_pos.set_legal_moves(0);
+        besteval = mated_in(ss->ply);
+        ttWriter.write(posKey, value_to_tt(besteval, ss->ply), PvNode, BOUND_EXACT, depth,
+                       Move::none(), ss->staticEval, m_tt->generation());
+        return besteval;
+    }
+
+    if (besteval >= beta && !m_pos.capture_stage(bestmove))
+        update_quiet_stats(ss, bestmove, quietsSearched, quietCount, depth);
+
+    ttWriter.write(posKey, value_to_tt(besteval, ss->ply), PvNode,
                    besteval >= beta     ? BOUND_LOWER
                    : PvNode && bestmove ? BOUND_EXACT
                                         : BOUND_UPPER,
-                   depth, bestmove, besteval, m_tt->generation());
+                   depth, bestmove, ss->staticEval, m_tt->generation());
     return besteval;
 }
 
 template<bool HaveTimeout>
 template<SearchRunType nodeType>
-Value search<HaveTimeout>::qnegmax(Stack* ss, Value alpha, Value beta) {
+Value search<HaveTimeout>::qnegmax(Stack* ss, Value alpha, Value beta, Depth depth) {
 
     constexpr bool PvNode = nodeType == PV;
-    Value          eval   = evaluate(m_pos);
+    assert(depth <= 0);
+
+    if constexpr (HaveTimeout)
+        check_time();
 
-    // standing pat
-    if (eval >= beta)
+    qrun++;
+    Move pv[MAX_PLY];
+    if (PvNode)
     {
-        return beta;
+        (ss + 1)->pv = pv;
+        ss->pv[0]    = Move::none();
     }
-    if (eval > alpha)
+
+    Key        posKey  = m_pos.key();
+    const bool inCheck = m_pos.checkers();
+
+    // Quiet checks are only tried at the first qsearch ply, the TT depth tells
+    // whether an entry has seen them
+    const Depth ttDepth = inCheck || depth >= DEPTH_QS_CHECKS ? DEPTH_QS_CHECKS : DEPTH_QS_NORMAL;
+
+    auto [ttHit, ttData, ttWriter] = m_tt->probe(posKey);
+    ttData.value                   = ttHit ? value_from_tt(ttData.value, ss->ply) : VALUE_NONE;
+    ++ttProbes;
+    ttHits += ttHit;
+
+    if (!PvNode && ttData.depth >= ttDepth && ttData.value != VALUE_NONE
+        && (ttData.bound & (ttData.value >= beta ? BOUND_LOWER : BOUND_UPPER)))
     {
-        alpha = eval;
+        return ttData.value;
     }
 
-    qrun++;
-    Key posKey                     = m_pos.key();
-    auto [ttHit, ttData, ttWriter] = m_tt->probe(posKey);
-    /*     if (ttHit && ttData.depth >= DEPTH_QS_CHECKS)
+    // The TT keeps the raw static eval, the mate distance is applied per ply
+    Value rawEval = ttHit && ttData.eval != VALUE_NONE ? ttData.eval : static_eval();
+    Value eval    = mate_adjusted(rawEval, ss->ply);
+
+    // evaluate() scores finished games, there is nothing left to search
+    if (rawEval == VALUE_MATE || rawEval == -VALUE_MATE)
     {
-        return ttData.eval;
-    } */
+        ttWriter.write(posKey, value_to_tt(eval, ss->ply), false, BOUND_EXACT, DEPTH_QS_CHECKS,
+                       Move::none(), rawEval, m_tt->generation());
+        return eval;
+    }
+
+    Value bestValue, futilityBase;
+    if (inCheck)
+    {
+        // No standing pat in check, every evasion is searched
+        bestValue = futilityBase = -VALUE_INFINITE;
+    }
+    else
+    {
+        // standing pat, unless there is no move to stand on: a stalemate is lost
+        if (eval >= beta && !m_pos.has_legal_moves())
+        {
+            bestValue = mated_in(ss->ply);
+            ttWriter.write(posKey, value_to_tt(bestValue, ss->ply), false, BOUND_EXACT,
+                           DEPTH_QS_CHECKS, Move::none(), rawEval, m_tt->generation());
+            return bestValue;
+        }
+        if (eval >= beta)
+        {
+            if (!ttHit)
+                ttWriter.write(posKey, value_to_tt(eval, ss->ply), false, BOUND_LOWER,
+                               DEPTH_UNSEARCHED, Move::none(), rawEval, m_tt->generation());
+            return beta;
+        }
+        if (eval > alpha)
+        {
+            alpha = eval;
+        }
+        bestValue    = eval;
+        futilityBase = eval + 200;
+    }
 
     // Check if we have an upcoming move that draws by repetition (~1 Elo)
     if (alpha < VALUE_DRAW && m_pos.upcoming_repetition(ss->ply))
@@ -236,58 +461,61 @@ Value search<HaveTimeout>::qnegmax(Stack* ss, Value alpha, Value beta) {
         }
     }
 
-    auto moves    = CustomMovePickerForQSearch(m_pos, m_tt);
-    auto allmoves = MoveList<Stockfish::LEGAL>(m_pos);
+    auto moves    = CustomMovePickerForQSearch(m_pos, ttHit ? ttData.move : Move::none(),
+                                               ttDepth == DEPTH_QS_CHECKS);
+    Move bestMove = Move::none();
+    bool anyLegal = false;
 
-    if (allmoves.size() == 0)
+    for (auto& m : moves)
     {
-        ttWriter.write(m_pos.key(), VALUE_ZERO, false, Stockfish::BOUND_UPPER, DEPTH_UNSEARCHED,
-                       Move::none(), eval, m_tt->generation());
-        return eval;
-    }
-
-    Value bestValue        = eval;
-    Move  bestMove         = Move::none();
-    Value value            = bestValue;
-    bool  played_something = false;
+        if (!m_pos.legal(m))
+            continue;
 
-    Move pv[MAX_PLY];
-    // Step 1. Initialize node
-    if (PvNode)
-    {
-        (ss + 1)->pv = pv;
-        ss->pv[0]    = Move::none();
-    }
+        anyLegal        = true;
+        bool givesCheck = m_pos.gives_check(m);
 
-    size_t movecount = 0;
-    for (auto& m : moves)
-    {
-        if constexpr (HaveTimeout)
+        if (!inCheck)
         {
-            if (stopflag)
-                break;
+            // Delta pruning, even winning the piece does not reach alpha
+            if (!givesCheck && m.type_of() != PROMOTION)
+            {
+                Value futilityValue = futilityBase + PieceValue[m_pos.piece_on(m.to_sq())];
+                if (futilityValue <= alpha)
+                {
+                    bestValue = std::max(bestValue, futilityValue);
+                    continue;
+                }
+                if (futilityBase <= alpha && !m_pos.see_ge(m, 1))
+                {
+                    bestValue = std::max(bestValue, futilityBase);
+                    continue;
+                }
+            }
+
+            // Moves that lose material can not raise the stand pat score
+            if (!m_pos.see_ge(m))
+                continue;
         }
+
         (ss + 1)->pv    = pv;
         (ss + 1)->pv[0] = Move::none();
-        movecount++;
-        bool givesCheck = m_pos.gives_check(m);
 
-        if (!m_pos.legal(m))
-            continue;
-
-        if (!givesCheck && movecount > 2)
-            break;
-
-        played_something = true;
+        prefetch(m_tt->first_entry(m_pos.key_after(m)));
 
         StateInfo st;
         this->nodes.fetch_add(1, std::memory_order_relaxed);
         m_pos.do_move(m, st);
-        ss->move = m;
-        value    = -qnegmax<nodeType>(ss + 1, -beta, -alpha);
+        ss->move    = m;
+        Value value = -qnegmax<nodeType>(ss + 1, -beta, -alpha, depth - 1);
         m_pos.undo_move(m);
         ss->move = Move::none();
 
+        if constexpr (HaveTimeout)
+        {
+            if (stopflag)
+                return VALUE_ZERO;
+        }
+
         assert(value > -VALUE_INFINITE && value < VALUE_INFINITE);
 
         if (value > bestValue)
@@ -314,15 +542,21 @@ Value search<HaveTimeout>::qnegmax(Stack* ss, Value alpha, Value beta) {
         }
     }
 
-    if (moves.size() == 0 || !played_something)
+    // Without a legal move the side to move has lost, as in GameEndDetector.
+    // In check the evasions were all the moves. Otherwise only a position
+    // without a legal capture or check needs a look at the quiet moves.
+    if (!anyLegal && (inCheck || !has_legal_quiet(m_pos)))
     {
-        auto res = evaluate(m_pos);
-        ttWriter.write(m_pos.key(), VALUE_ZERO, false, Stockfish::BOUND_EXACT, DEPTH_UNSEARCHED,
-                       Move::none(), res, m_tt->generation());
-        return res;
+        m_pos.set_legal_moves(0);
+        bestValue = mated_in(ss->ply);
+        ttWriter.write(posKey, value_to_tt(bestValue, ss->ply), false, BOUND_EXACT,
+                       DEPTH_QS_CHECKS, Move::none(), rawEval, m_tt->generation());
+        return bestValue;
     }
-    ttWriter.write(posKey, VALUE_ZERO, false, bestValue >= beta ? BOUND_LOWER : BOUND_UPPER,
-                   DEPTH_QS_CHECKS, bestMove, bestValue, m_tt->generation());
+
+    ttWriter.write(posKey, value_to_tt(bestValue, ss->ply), false,
+                   bestValue >= beta ? BOUND_LOWER : BOUND_UPPER, ttDepth, bestMove, rawEval,
+                   m_tt->generation());
     assert(bestValue > -VALUE_INFINITE && bestValue < VALUE_INFINITE);
 
     return bestValue;
@@ -330,14 +564,15 @@ Value search<HaveTimeout>::qnegmax(Stack* ss, Value alpha, Value beta) {
 
 template<bool HaveTimeout>
 Move search<HaveTimeout>::iterative_deepening_background(int d) {
-    if (m_pos.gameEndDetector.Analyse(m_pos) != Stockfish::GameEndDetector::None)
-        return Move::none();
-
+    rootMoves.clear();
+    completedDepth     = 0;
+    totBestMoveChanges = 0;
+    bestMoveChanges.store(0, std::memory_order_relaxed);
+    // The root moves are generated once, game_end() then only looks them up
     auto moves = MoveList<Stockfish::LEGAL>(m_pos);
-    if (moves.size() == 0)
-    {
+    m_pos.set_legal_moves(moves.size());
+    if (m_pos.game_end() != Stockfish::GameEndDetector::None)
         return Move::none();
-    }
     for (auto move : moves)
     {
         //std::cout << "inserting root move : " << move << std::endl;
@@ -363,6 +598,7 @@ Move search<HaveTimeout>::iterative_deepening_background(int d) {
 
     Value alpha = -VALUE_INFINITE, beta = VALUE_INFINITE;
     //int   searchAgainCounter = 0;
+    Value lastBestValue = -VALUE_INFINITE;
 
     for (rootDepth = 1; rootDepth <= d; rootDepth++)
     {
@@ -371,6 +607,16 @@ Move search<HaveTimeout>::iterative_deepening_background(int d) {
             if (stopflag)
                 break;
         }
+        TimePoint iterationStart = now();
+        // Older iterations searched shallower trees, let new cutoffs dominate
+        mainHistory.age();
+
+        if (m_threadIdx > 0)
+        {
+            int i = (m_threadIdx - 1) % std::size(SkipSize);
+            if (rootDepth < d && ((rootDepth + m_pos.gamePly + SkipPhase[i]) / SkipSize[i]) % 2)
+                continue;
+        }
         // MultiPV loop. We perform a full root search for each PV line
 
         // Save the last iteration's scores before the first PV line is searched and
@@ -394,6 +640,7 @@ Move search<HaveTimeout>::iterative_deepening_background(int d) {
                 if (stopflag)
                     break;
             }
+            selDepth = 0;
             if (pvIdx == pvLast)
             {
                 pvFirst = pvLast;
@@ -469,16 +716,27 @@ Move search<HaveTimeout>::iterative_deepening_background(int d) {
                   << ", alpha = " << alpha << ", beta = " << beta << ", avg = " << avg
                   << ", stopper flag = " << stopflag
                   << ", elapsed_us = " << elapsed_us(std::chrono::system_clock::now()) << std::endl; */
-        if (std::abs(rootMoves[0].score) == VALUE_MATE)
+        if constexpr (HaveTimeout)
+        {
+            if (stopflag)
+                break;
+        }
+        completedDepth = std::max(completedDepth, adjustedDepth);
+        if (m_threadIdx == 0 && onIteration)
+            onIteration(completedDepth, rootMoves[0]);
+
+        if (std::abs(rootMoves[0].score) >= VALUE_MATE_IN_MAX_PLY)
         {
             break;
         }
+
         if constexpr (HaveTimeout)
         {
-            if (stopflag)
+            if (useTimeManagement && m_threadIdx == 0
+                && time_to_stop(lastBestValue, now() - iterationStart))
                 break;
         }
-        completedDepth = std::max(completedDepth, adjustedDepth);
+        lastBestValue = rootMoves[0].score;
     }
 
     //pv_manager2.dump();
@@ -490,6 +748,28 @@ Move search<HaveTimeout>::iterative_deepening_background(int d) {
     } */
     return rootMoves[0].pv[0];
 }
+// Called by the main thread after every completed iteration of a clock
+// managed search. Best move changes decay by half per iteration, so only
+// recent instability stretches the soft limit. The next iteration is expected
+// to take about twice as long as this one; it is not started when that would
+// run into the hard limit and be thrown away.
+template<bool HaveTimeout>
+bool search<HaveTimeout>::time_to_stop(Value previousBest, TimePoint iterationTime) {
+    totBestMoveChanges =
+      totBestMoveChanges / 2 + bestMoveChanges.exchange(0, std::memory_order_relaxed);
+
+    uint64_t totalEffort = 0;
+    for (const RootMove& rm : rootMoves)
+        totalEffort += rm.effort;
+    double bestMoveEffort = totalEffort ? double(rootMoves[0].effort) / totalEffort : 0.0;
+    Value  scoreDrop =
+      previousBest == -VALUE_INFINITE ? VALUE_ZERO : previousBest - rootMoves[0].score;
+
+    TimePoint elapsed = now() - startTime;
+    return elapsed >= tm.soft_limit(totBestMoveChanges, scoreDrop, bestMoveEffort)
+        || elapsed + 2 * iterationTime > tm.maximum();
+}
+
 template class search<true>;
 
 template class search<false>;
@@ -5,13 +5,18 @@
 #include "../stockfish_position.h"
 #include "../movegen.h"
 
-#include "timer.h"
-
 #include <chrono>
 #include <condition_variable>
 #include <cstddef>
+#include <functional>
 #include <mutex>
 #include "pv_manager.h"
+#include "custommovepicker.h"
+#include "eval_cache.h"
+#include "evaluate.h"
+#include "material.h"
+#include "pawns.h"
+#include "timeman.h"
 #include <atomic>
 #include <thread>
 
@@ -27,6 +32,7 @@ struct Stack {
     bool  improving;
     bool  ttHit;
     Move  ttMove;
+    Move  killers[2];
 };
 
 enum SearchRunType {
@@ -62,6 +68,10 @@ struct RootMove {
 
 using RootMoves = std::vector<RootMove>;
 
+// Called on the search thread after every completed iteration of the main
+// thread, with the completed depth and the best root move.
+using IterationCallback = std::function<void(Depth, const RootMove&)>;
+
 template<bool HaveTimeOut = true>
 class search {
     // Sort moves in descending order up to and including
@@ -81,11 +91,30 @@ class search {
 
     Value value_draw(size_t nodes) { return VALUE_DRAW - 1 + Value(nodes & 0x2); }
 
+    // evaluate() with this thread's pawn and material tables, through the
+    // shared eval cache when there is one
+    Value static_eval() {
+        Value v;
+        if (evalCache)
+        {
+            ++evalCacheProbes;
+            if (evalCache->probe(m_pos.key(), v))
+            {
+                ++evalCacheHits;
+                return v;
+            }
+        }
+        v = evaluate(m_pos, &pawnsTable, &materialTable);
+        if (evalCache)
+            evalCache->store(m_pos.key(), v);
+        return v;
+    }
+
     template<SearchRunType nodeType>
     Value negmax(Stack* ss, int depth, Value alpha, Value beta, bool cutNode = true);
 
     template<SearchRunType nodeType>
-    Value qnegmax(Stack* ss, Value alpha, Value beta);
+    Value qnegmax(Stack* ss, Value alpha, Value beta, Depth depth);
 
     TTData GetFromTT() {
         auto [ttHit, ttData, ttWriter] = m_tt->probe(m_pos.key());
@@ -110,14 +139,16 @@ class search {
 
     Move iterative_deepening_background(int d = 20);
 
+    void update_quiet_stats(Stack* ss, Move bestMove, const Move* quiets, int quietCount, int depth);
+
+    bool time_to_stop(Value previousBest, TimePoint iterationTime);
+
     void update_pv(Move* pv, Move move, const Move* childPv) {
         for (*pv++ = move; childPv && *childPv != Move::none();)
             *pv++ = *childPv++;
         *pv = Move::none();
     }
 
-    void stop() { stopflag = true; }
-
     std::chrono::seconds elapsed_us() {
         return std::chrono::duration_cast<std::chrono::seconds>(end - start);
     }
@@ -125,33 +156,92 @@ class search {
         return std::chrono::duration_cast<std::chrono::seconds>(mend - start);
     }
 
+    // The worker sleeps until start_parallel_root() raises busy, searches,
+    // then lowers busy and sleeps again. It exits when the search is destroyed.
+    void idle_loop() {
+        while (true)
+        {
+            std::unique_lock<std::mutex> lk(m);
+            cv.wait(lk, [&]() { return busy.load() || exiting; });
+            if (exiting)
+                return;
+            int d = pendingDepth;
+            lk.unlock();
+
+            this->iterative_deepening_background(d);
+            end = std::chrono::system_clock::now();
+
+            lk.lock();
+            busy.store(false);
+            lk.unlock();
+            cv.notify_all();
+        }
+    }
+
+    // Polls the clock every 1024 nodes and raises the stop flag at the deadline
+    void check_time() {
+        if (--callsCnt > 0)
+            return;
+        callsCnt = 1024;
+        if (std::chrono::steady_clock::now() >= deadline)
+            stopflag = true;
+    }
+
    public:
     search(TranspositionTable*       tt,
            Position&                 pos,
-           std::chrono::milliseconds t = std::chrono::seconds(3600)) :
+           std::chrono::milliseconds t         = std::chrono::seconds(3600),
+           size_t                    threadIdx = 0) :
         m_tt(tt),
         m_pos(pos),
+        m_threadIdx(threadIdx),
+        m_time(t),
         stopflag(false),
-        timeChecker(stopflag, t) {}
+        worker([this]() { idle_loop(); }) {}
+
+    search(const search&)            = delete;
+    search& operator=(const search&) = delete;
 
     void start_parallel_root(int d = 20) {
-        stop();
-        parallel_thread_for_search = std::thread([&]() {
-            std::unique_lock<std::mutex> lock(m);
-            cv.wait(lock, [&]() { return busy.load() == false; });
-            stopflag = false;
+        LimitsType limits;
+        limits.depth = d;
+        start_parallel_root(limits);
+    }
+
+    // busy is raised before the worker is woken up, so a stop() or
+    // block_for_search() issued right after this call always sees the search.
+    // Without a clock or movetime in the limits the constructor's time applies.
+    void start_parallel_root(const LimitsType& limits) {
+        if (busy.load())
+        {
+            stop();
+            block_for_search();
+        }
+        {
+            std::unique_lock<std::mutex> lk(m);
+            tm.init(limits, m_pos.side_to_move(), m_pos.gamePly);
+            useTimeManagement = limits.use_time_management();
+            auto hardLimit    = useTimeManagement || limits.movetime
+                                ? std::chrono::milliseconds(tm.maximum())
+                                : m_time;
+
+            // The main thread opens a new TT generation once per go, entries
+            // of earlier searches then age out of the buckets first
+            if (m_threadIdx == 0)
+                m_tt->new_search();
+
+            stopflag     = false;
+            nodes        = 0;
+            evalCacheProbes = evalCacheHits = 0;
+            ttProbes = ttHits = 0;
+            pendingDepth = limits.depth > 0 ? limits.depth : Stockfish::MAX_PLY - 1;
+            callsCnt     = 1024;
+            start        = std::chrono::system_clock::now();
+            startTime    = now();
+            deadline     = std::chrono::steady_clock::now() + hardLimit;
             busy.store(true);
-            start = std::chrono::system_clock::now();
-            if constexpr (HaveTimeOut)
-            {
-                timeChecker.Reset();
-            }
-            this->iterative_deepening_background(d);
-            timeChecker.Cancel();
-            end = std::chrono::system_clock::now();
-            busy.store(false);
-            cv.notify_all();
-        });
+        }
+        cv.notify_all();
     }
 
     Move iterative_deepening(int d = 20) {
@@ -160,12 +250,26 @@ class search {
         return picked_move();
     }
 
+    Move iterative_deepening(const LimitsType& limits) {
+        start_parallel_root(limits);
+        block_for_search();
+        return picked_move();
+    }
+
     void block_for_search() {
-        std::this_thread::sleep_for(std::chrono::milliseconds(500));
         std::unique_lock<std::mutex> lk(m);
         cv.wait(lk, [&]() { return busy.load() == false; });
     }
 
+    void stop() { stopflag = true; }
+
+    void on_iteration(IterationCallback cb) { onIteration = std::move(cb); }
+
+    // nullptr or a disabled cache turns the eval cache off
+    void set_eval_cache(EvalCache* cache) {
+        evalCache = cache && cache->enabled() ? cache : nullptr;
+    }
+
     Move picked_move() {
         if (rootMoves.size() > 0)
             return rootMoves[0].pv[0];
@@ -174,33 +278,79 @@ class search {
     }
     Value picked_move_score() { return rootMoves[0].score; }
 
-    ~search() { parallel_thread_for_search.join(); }
+    const RootMoves&       root_moves() const { return rootMoves; }
+    uint64_t               nodes_searched() const { return nodes.load(std::memory_order_relaxed); }
+    size_t                 thread_index() const { return m_threadIdx; }
+    uint64_t               negmax_nodes() const { return pvrun + nonpvrun + rootrun; }
+    uint64_t               qsearch_nodes() const { return qrun; }
+    uint64_t               scored_moves() const { return scoredMoves; }
+    const Pawns::Table&    pawns_table() const { return pawnsTable; }
+    const Material::Table& material_table() const { return materialTable; }
+    uint64_t               eval_cache_probes() const { return evalCacheProbes; }
+    uint64_t               eval_cache_hits() const { return evalCacheHits; }
+    uint64_t               tt_probes() const { return ttProbes; }
+    uint64_t               tt_hits() const { return ttHits; }
+
+    ~search() {
+        stop();
+        {
+            std::unique_lock<std::mutex> lk(m);
+            exiting = true;
+        }
+        cv.notify_all();
+        worker.join();
+    }
 
-    Depth completedDepth, rootDepth;
+    Depth completedDepth = 0, rootDepth = 0;
 
    private:
     const static int    MAX_PLY = 500;
     TranspositionTable* m_tt;
     Position&           m_pos;
+    size_t              m_threadIdx;
     PVManager2          pv_manager2;
     RootMoves           rootMoves;
     size_t              multiPV = 1;
     Value               rootDelta;
-    std::thread         parallel_thread_for_search;
+    int                 selDepth = 0;
+    IterationCallback   onIteration;
 
     long pvrun    = 0;
     long nonpvrun = 0;
     long rootrun  = 0;
     long qrun     = 0;
 
+    uint64_t scoredMoves = 0;
+
+    ButterflyHistory   mainHistory;
+    CounterMoveHistory counterMoves = {};
+    Pawns::Table       pawnsTable;
+    Material::Table    materialTable;
+    EvalCache*         evalCache       = nullptr;
+    uint64_t           evalCacheProbes = 0;
+    uint64_t           evalCacheHits   = 0;
+    uint64_t           ttProbes        = 0;
+    uint64_t           ttHits          = 0;
+
     std::atomic<uint64_t>    nodes, tbHits, bestMoveChanges;
     int                      delta;
     size_t                   pvIdx, pvLast;
-    std::atomic<bool>        stopflag = false, busy = false;
-    TimeChecker<false>                                 timeChecker;
-    std::condition_variable  cv;
-    std::mutex               m;
+    std::chrono::milliseconds                          m_time;
+    TimeManagement                                     tm;
+    bool                                               useTimeManagement  = false;
+    double                                             totBestMoveChanges = 0;
+    TimePoint                                          startTime          = 0;
+    std::chrono::steady_clock::time_point              deadline;
+    int                                                callsCnt     = 1024;
+    int                                                pendingDepth = 0;
+    std::atomic<bool>                                  stopflag = false, busy = false;
+    bool                                               exiting  = false;
+    std::condition_variable                            cv;
+    std::mutex                                         m;
     std::chrono::time_point<std::chrono::system_clock> start;
     std::chrono::time_point<std::chrono::system_clock> end;
+
+    // Declared last, it starts running idle_loop() once everything above is built
+    std::thread worker;
 };
 }
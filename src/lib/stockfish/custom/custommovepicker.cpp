@@ -1,307 +1,213 @@
 #include "custommovepicker.h"
+#include "../movegen.h"
 
-namespace Stockfish {
+#include <cassert>
+#include <iterator>
+#include <limits>
 
-int MoveSorter::DetermineEvasionType(Position& pos, Move& m, const bool debug) {
-    if (debug)
-        std::cout << "determining evasion type " << m << std::endl;
-    Piece     pc = pos.moved_piece(m);
-    PieceType pt = type_of(pc);
-    // Square    from = m.from_sq();
-    Square to = m.to_sq();
+namespace Stockfish {
 
-    Piece targetPosPiece = pos.piece_on(to);
+CustomMovePicker::CustomMovePicker(const Position&         p,
+                                   Move                    ttm,
+                                   const Move*             killers,
+                                   const ButterflyHistory* mh,
+                                   Move                    cm) :
+    pos(p),
+    mainHistory(mh),
+    ttMove(ttm) {
+    refutations[0] = killers[0];
+    refutations[1] = killers[1];
+    refutations[2] = cm;
+    stage = (pos.checkers() ? EVASION_TT : MAIN_TT) + !(ttm && pos.pseudo_legal(ttm));
+}
 
-    int retscore = EVASION_COEFFICIENT;
-    // evasion capturing
-    if (targetPosPiece != NO_PIECE)
-    {
-        retscore += 5 * move_arround;
-        if (pt == KING)
-        {
-            retscore += -move_arround;
-        }
-        else
-        {
-            retscore += +move_arround + capturing_offset(pt, type_of(targetPosPiece));
-        }
-    }
-    // evasion moving king
-    else if (pt == KING)
-    {
-        // todo reveal threading move away
-        retscore += -2 * move_arround;
-    }
-    else  // evasion blocking by other piece
-    {
-        auto [p_protected, protectingPt, p_capturable, capturingPt] =
-          pos.IsMoveToAProtectedPosition(m);
-        if (p_protected && p_capturable)
-        {
-            retscore += 3 * move_arround + capturing_offset(capturingPt, protectingPt);
-        }
-        else if (!p_protected && p_capturable)
-        {
-            retscore += -3 * move_arround;
-        }
-        else if (p_protected && !p_capturable)  // not possible most probably
-        {
-            retscore += +3 * move_arround;
-        }
-        else
-        {
-            // not possible most probably
-            retscore += +2 * move_arround;
-        }
-    }
-    if (pos.gives_check(m))
-        retscore += CHECK_COEFFICIENT;
-    return retscore;
+// A capture is held back to the bad capture stage when the static exchange
+// loses material. The MVV-LVA score gives captures of valuable pieces a bit of
+// slack, as in Stockfish.
+bool CustomMovePicker::good_capture(const ExtMove& m) const {
+    return pos.see_ge(m, -m.value / 18);
 }
 
-int MoveSorter::DetermineCaptureType(Position& pos, Move& m, const bool debug) {
-    if (debug)
-        std::cout << "determining capture type " << m << std::endl;
-    Piece     capturingPiece     = pos.moved_piece(m);
-    PieceType capturingPieceType = type_of(capturingPiece);
-    // Square    from               = m.from_sq();
-    // Square    to                = m.to_sq();
-    Piece     capturedPiece     = pos.piece_on(m.to_sq());
-    PieceType capturedPieceType = type_of(capturedPiece);
-
-    auto [p_protected, protectingPt, pos_counterCapturable, counterCapturingPieceType] =
-      pos.IsMoveToAProtectedPosition(m);
-
-    int retscore = CAPTURE_COEFFICIENT;
-    if (!p_protected)
+template<GenType Type>
+void CustomMovePicker::score() {
+
+    static_assert(Type == CAPTURES || Type == QUIETS || Type == EVASIONS, "Wrong type");
+
+    [[maybe_unused]] Bitboard threatenedByPawn, threatenedByMinor, threatenedPieces;
+    if constexpr (Type == QUIETS)
     {
-        if (!pos_counterCapturable)
-        {
-            if (debug)
-                std::cout << "not protected and not counter capturable " << m << std::endl;
-            retscore = +CAPTURE_COEFFICIENT;
-            if (PieceValue[capturingPieceType] > PieceValue[capturedPieceType])
-            {
-                if (capturingPieceType == ROOK)
-                    retscore -= 14 * move_arround;
-                else if (capturingPieceType == BISHOP || capturingPieceType == QUEEN
-                         || capturingPieceType == KNIGHT)
-                    retscore -= 8 * move_arround;
-                else
-                    retscore -= 3 * move_arround;
-            }
-            else
-            {
-                if (capturedPieceType == ROOK)
-                    retscore += 14 * move_arround;
-                else if (capturedPieceType == BISHOP || capturedPieceType == QUEEN
-                         || capturedPieceType == KNIGHT)
-                    retscore += 8 * move_arround;
-                else
-                    retscore += 3 * move_arround;
-            }
-        }
-        else if (pos_counterCapturable)
-        {
-            if (debug)
-                std::cout << "not protected and counter capturable, losing capture" << m
-                          << std::endl;
-            if (PieceValue[capturingPieceType] > PieceValue[capturedPieceType])
-            {
-                retscore = -CAPTURE_COEFFICIENT;
-
-                if (PieceValue[counterCapturingPieceType] > PieceValue[capturingPieceType])
-                {
-                    retscore += move_arround;
-                }
-                else
-                {
-                    retscore -= move_arround;
-                }
-            }
-            else if (PieceValue[capturingPieceType] == PieceValue[capturedPieceType])
-            {
-                retscore = +CAPTURE_COEFFICIENT;
-            }
-            else
-            {
-                retscore = +CAPTURE_COEFFICIENT + 13 * move_arround;
-            }
-        }
+        Color us = pos.side_to_move();
+
+        threatenedByPawn  = pos.attacks_by<PAWN>(~us);
+        threatenedByMinor = pos.attacks_by<QUEEN>(~us) | pos.attacks_by<KNIGHT>(~us)
+                          | pos.attacks_by<BISHOP>(~us) | threatenedByPawn;
+
+        // Pieces threatened by pieces of lesser material value
+        threatenedPieces = (pos.pieces(us, ROOK) & threatenedByMinor)
+                         | (pos.pieces(us, KNIGHT, BISHOP, QUEEN) & threatenedByPawn);
     }
-    else if (p_protected)
+
+    for (ExtMove* m = cur; m != endMoves; ++m)
     {
-        if (!pos_counterCapturable)
-        {
-            if (debug)
-                std::cout << "protected and not counter capturable " << m << std::endl;
-            retscore = +CAPTURE_COEFFICIENT + 13 * move_arround;
-            if (capturedPieceType == ROOK)
-                retscore += 14 * move_arround;
-            else if (capturedPieceType == BISHOP || capturedPieceType == QUEEN
-                     || capturedPieceType == KNIGHT)
-                retscore += 8 * move_arround;
-            else
-                retscore += 3 * move_arround;
-        }
-        else if (pos_counterCapturable)
-        {
-            if (debug)
-                std::cout << "protected and counter capturable " << m << std::endl;
-            if (PieceValue[capturingPieceType] > PieceValue[capturedPieceType])
-            {
-                retscore = -CAPTURE_COEFFICIENT;
-                if (PieceValue[counterCapturingPieceType] > PieceValue[capturingPieceType])
-                {
-                    retscore += move_arround;
-                }
-                else
-                {
-                    retscore -= move_arround;
-                }
-            }
-            else if (PieceValue[capturingPieceType] == PieceValue[capturedPieceType])
-            {
-                retscore = +CAPTURE_COEFFICIENT + 3 * move_arround;
-            }
-            else
-            {
-                retscore = +CAPTURE_COEFFICIENT + 13 * move_arround;
-            }
-        }
-    }
+        Piece     pc = pos.moved_piece(*m);
+        PieceType pt = type_of(pc);
+        Square    to = m->to_sq();
 
-    if (pos.gives_check(m))
-        retscore += CHECK_COEFFICIENT;
+        if constexpr (Type == CAPTURES)
+            m->value = 7 * int(PieceValue[pos.piece_on(to)]) - int(PieceValue[pt]) / 8;
 
-    return retscore;
-}
+        else if constexpr (Type == QUIETS)
+        {
+            Square from = m->from_sq();
 
-int MoveSorter::DetermineQuiteType(Position& pos, Move& m, const bool debug) {
-    if (debug)
-        std::cout << "determining quite type " << m << std::endl;
-    Piece     movingPiece     = pos.moved_piece(m);
-    PieceType movingPieceType = type_of(movingPiece);
-    // Square    from            = m.from_sq();
-    // Square to = m.to_sq();
+            m->value = mainHistory->get(pos.side_to_move(), *m);
 
-    Bitboard oppAttacksToTo =
-      pos.attackers_to(m.to_sq(), pos.pieces()) & pos.pieces(~pos.side_to_move());
-    Bitboard oppAttackToFrom =
-      pos.attackers_to(m.from_sq(), pos.pieces()) & pos.pieces(~pos.side_to_move());
+            // bonus for checks
+            m->value += bool(pos.check_squares(pt) & to) * 7000;
 
-    auto [p_protected, protectingPt, pos_counterCapturable, counterCapturingPieceType] =
-      pos.IsMoveToAProtectedPosition(m);
+            // bonus for escaping from capture
+            m->value += threatenedPieces & from ? (pt == ROOK && !(to & threatenedByMinor) ? 256
+                                                   : !(to & threatenedByPawn)              ? 144
+                                                                                           : 0)
+                                                : 0;
 
-    int retscore = QUIET_COEFFICIENT;
+            // malus for putting piece en prise
+            m->value -=
+              (pt == ROOK ? bool(to & threatenedByMinor) * 243 : bool(to & threatenedByPawn) * 149);
+        }
 
-    if (p_protected)
-    {
-        if (pos_counterCapturable)
+        else  // Type == EVASIONS
         {
-            if (PieceValue[counterCapturingPieceType] < PieceValue[movingPieceType])
-            {
-                retscore = -QUIET_COEFFICIENT;
-            }
+            if (pos.capture_stage(*m))
+                m->value = PieceValue[pos.piece_on(to)] - PieceValue[pt] + (1 << 28);
             else
-            {
-                retscore = +QUIET_COEFFICIENT;
-            }
-        }
-        else
-        {
-            retscore = +QUIET_COEFFICIENT + 2 * move_arround;
+                m->value = mainHistory->get(pos.side_to_move(), *m);
         }
     }
-    else
-    {
-        if (pos_counterCapturable)
-        {
-            if (PieceValue[counterCapturingPieceType] < PieceValue[movingPieceType])
-            {
-                retscore = -QUIET_COEFFICIENT - 10 * move_arround;
-            }
-            else
-            {
-                retscore = -QUIET_COEFFICIENT - 8 * move_arround;
-            }
-        }
-        else
+    scoredCount += endMoves - cur;
+}
+
+// Sort moves in descending order up to and including a given limit. The order
+// of moves smaller than the limit is left unspecified.
+void CustomMovePicker::partial_insertion_sort(ExtMove* begin, ExtMove* end, int limit) {
+
+    for (ExtMove *sortedEnd = begin, *p = begin + 1; p < end; ++p)
+        if (p->value >= limit)
         {
-            retscore = QUIET_COEFFICIENT;
+            ExtMove tmp = *p, *q;
+            *p          = *++sortedEnd;
+            for (q = sortedEnd; q != begin && *(q - 1) < tmp; --q)
+                *q = *(q - 1);
+            *q = tmp;
         }
-    }
+}
 
-    if (oppAttackToFrom != 0)
+// Returns the next pseudo legal move, or Move::none() when the moves are
+// exhausted.
+Move CustomMovePicker::next_move() {
+
+top:
+    switch (stage)
     {
-        if (oppAttacksToTo != 0)
+    case MAIN_TT :
+    case EVASION_TT :
+        ++stage;
+        return ttMove;
+
+    case CAPTURE_INIT :
+        cur = endBadCaptures = moves;
+        endMoves             = generate<CAPTURES>(pos, cur);
+
+        score<CAPTURES>();
+        partial_insertion_sort(cur, endMoves, std::numeric_limits<int>::min());
+        ++stage;
+        goto top;
+
+    case GOOD_CAPTURE :
+        while (cur < endMoves)
         {
-            if (movingPieceType == ROOK)
-                retscore -= 14 * move_arround;
-            else if (movingPieceType == BISHOP || movingPieceType == QUEEN
-                     || movingPieceType == KNIGHT)
-                retscore -= 8 * move_arround;
-            else
-                retscore -= 3 * move_arround;
+            ExtMove& m = *cur++;
+            if (m == ttMove)
+                continue;
+            if (good_capture(m))
+                return m;
+
+            // Losing capture, move it to the tail of the bad capture list
+            *endBadCaptures++ = m;
         }
-        else
+
+        cur      = std::begin(refutations);
+        endMoves = std::end(refutations);
+        ++stage;
+        [[fallthrough]];
+
+    case REFUTATION :
+        // The countermove may repeat a killer, skip the duplicate
+        if (refutations[2] == refutations[0] || refutations[2] == refutations[1])
+            endMoves = std::begin(refutations) + 2;
+
+        while (!skipQuiets && cur < endMoves)
         {
-            if (movingPieceType == ROOK)
-                retscore += 14 * move_arround;
-            else if (movingPieceType == BISHOP || movingPieceType == QUEEN
-                     || movingPieceType == KNIGHT)
-                retscore += 8 * move_arround;
-            else
-                retscore += 3 * move_arround;
+            Move m = *cur++;
+            if (m && m != ttMove && !pos.capture_stage(m) && pos.pseudo_legal(m))
+                return m;
         }
-    }
-    else
-    {
-        if (oppAttacksToTo != 0)
+        ++stage;
+        [[fallthrough]];
+
+    case QUIET_INIT :
+        cur      = endBadCaptures;
+        endMoves = cur;
+        if (!skipQuiets)
         {
-            if (movingPieceType == ROOK)
-                retscore -= 14 * move_arround;
-            else if (movingPieceType == BISHOP || movingPieceType == QUEEN
-                     || movingPieceType == KNIGHT)
-                retscore -= 8 * move_arround;
-            else
-                retscore -= 3 * move_arround;
+            endMoves = generate<QUIETS>(pos, cur);
+
+            score<QUIETS>();
+            partial_insertion_sort(cur, endMoves, std::numeric_limits<int>::min());
         }
-        else
+        ++stage;
+        [[fallthrough]];
+
+    case QUIET :
+        while (!skipQuiets && cur < endMoves)
         {
-            if (movingPieceType == ROOK)
-                retscore += 14 * move_arround;
-            else if (movingPieceType == BISHOP || movingPieceType == QUEEN
-                     || movingPieceType == KNIGHT)
-                retscore += 8 * move_arround;
-            else
-                retscore += 3 * move_arround;
+            Move m = *cur++;
+            if (m != ttMove && m != refutations[0] && m != refutations[1]
+                && m != refutations[2])
+                return m;
         }
-    }
 
-    if (pos.gives_check(m))
-        retscore += CHECK_COEFFICIENT;
+        cur      = moves;
+        endMoves = endBadCaptures;
+        ++stage;
+        [[fallthrough]];
 
-    return retscore;
-}
+    case BAD_CAPTURE :
+        if (cur < endMoves)
+            return *cur++;
+        return Move::none();
 
-int MoveSorter::DetermineScore(Position& pos, Move& m, Move& ttm) {
-    if (m == ttm)
-    {
-        return HASH_COEFFICIENT;
-    }
-    if (pos.checkers())
-    {
-        return DetermineEvasionType(pos, m);
-    }
-    else if (pos.capture_stage(m))
-    {
-        return DetermineCaptureType(pos, m);
-    }
-    else
-    {
-        return DetermineQuiteType(pos, m);
+    case EVASION_INIT :
+        cur      = moves;
+        endMoves = generate<EVASIONS>(pos, cur);
+
+        score<EVASIONS>();
+        partial_insertion_sort(cur, endMoves, std::numeric_limits<int>::min());
+        ++stage;
+        [[fallthrough]];
+
+    case EVASION :
+        while (cur < endMoves)
+        {
+            Move m = *cur++;
+            if (m != ttMove)
+                return m;
+        }
+        return Move::none();
     }
+
+    assert(false);
+    return Move::none();
 }
 
 }
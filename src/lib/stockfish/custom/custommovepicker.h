@@ -2,138 +2,114 @@
 
 #include "../types.h"
 #include "../stockfish_position.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
 #include "customtranspositiontable.h"
 
 #include "pv_manager.h"
 #include "../tt.h"
 namespace Stockfish {
 
-class MoveSorterInterface {
+// History of quiet moves by [color][from][to]. Updates use gravity: an entry
+// moves towards the bonus by a fraction that shrinks as it nears HistoryMax, so
+// it stays within bounds without clamping and old successes fade out.
+class ButterflyHistory {
    public:
-    Value DetermineScore(Position& pos, ExtMove& m) {
-
-        bool evasions = pos.checkers() != 0;
-        bool capture  = pos.capture_stage(m);
-
-        if (evasions)
-        {
-            if (capture)
-                m.value =
-                  PieceValue[pos.piece_on(m.to_sq())] - PieceValue[type_of(pos.moved_piece(m))];
-        }
-        else if (capture)
-        {
-            m.value =
-              int(PieceValue[pos.piece_on(m.to_sq())] - PieceValue[type_of(pos.moved_piece(m))]);
-        }
-        else
-        {
-
-            [[maybe_unused]] Bitboard threatenedByPawn, threatenedByMinor, threatenedByRook,
-              threatenedPieces;
-            Color us = pos.side_to_move();
-
-            threatenedByPawn  = pos.attacks_by<PAWN>(~us);
-            threatenedByMinor = pos.attacks_by<QUEEN>(~us) | pos.attacks_by<KNIGHT>(~us)
-                              | pos.attacks_by<BISHOP>(~us) | threatenedByPawn;
-            threatenedByRook = pos.attacks_by<ROOK>(~us) | threatenedByMinor;
-
-            // Pieces threatened by pieces of lesser material value
-            threatenedPieces = (pos.pieces(us, ROOK) & threatenedByMinor)
-                             | (pos.pieces(us, KNIGHT, BISHOP, QUEEN) & threatenedByPawn);
-
-            Piece     pc   = pos.moved_piece(m);
-            PieceType pt   = type_of(pc);
-            Square    from = m.from_sq();
-            Square    to   = m.to_sq();
-
-            // bonus for checks
-            m.value += bool(pos.check_squares(pt) & to) * 7000;
-
-            // bonus for escaping from capture
-            m.value += threatenedPieces & from ? (pt == ROOK && !(to & threatenedByMinor) ? 256
-                                                  : !(to & threatenedByPawn)              ? 144
-                                                                                          : 0)
-                                               : 0;
-
-            // malus for putting piece en prise
-            m.value -=
-              (pt == ROOK ? bool(to & threatenedByMinor) * 243 : bool(to & threatenedByPawn) * 149);
-        }
-        return m.value;
-    }
-};
-
-class MoveSorter {
-   protected:
-    using offset = int;
-    offset capturing_offset(PieceType capturing, PieceType beingcaptured) {
-        return PieceValue[beingcaptured] - PieceValue[capturing];
-    }
-
-    inline Bitboard GetThreatenPositionsByPawn(Position& pos) {
-        return pos.attacks_by<PAWN>(~pos.side_to_move());
-    }
+    static constexpr int HistoryMax = 7183;
 
-    inline Bitboard GetThreatenPositionsByMinor(Position& pos, Bitboard threatenedByPawn = 0) {
-        return pos.attacks_by<KNIGHT>(~pos.side_to_move())
-             | pos.attacks_by<BISHOP>(~pos.side_to_move())
-             | pos.attacks_by<QUEEN>(~pos.side_to_move()) | threatenedByPawn;
-    }
+    int get(Color c, Move m) const { return table[c][m.from_sq()][m.to_sq()]; }
 
-    inline Bitboard GetThreatenPositionsByRook(Position& pos, Bitboard threatenedByMinor = 0) {
-        return pos.attacks_by<ROOK>(~pos.side_to_move()) | threatenedByMinor;
+    void update(Color c, Move m, int bonus) {
+        int16_t& entry = table[c][m.from_sq()][m.to_sq()];
+        bonus          = std::clamp(bonus, -HistoryMax, HistoryMax);
+        entry += bonus - entry * std::abs(bonus) / HistoryMax;
     }
 
-    inline Bitboard
-    ThreatenedPieces(Position& pos, Bitboard threatenedByMinor, Bitboard threatenedByPawn) {
-        return (pos.pieces(pos.side_to_move(), ROOK) & threatenedByMinor)
-             | (pos.pieces(pos.side_to_move(), KNIGHT, BISHOP, QUEEN) & threatenedByPawn);
+    // Called between iterations, keeps three quarters of every entry
+    void age() {
+        for (auto& byFrom : table)
+            for (auto& byTo : byFrom)
+                for (auto& entry : byTo)
+                    entry = entry * 3 / 4;
     }
 
-    static constexpr int HASH_COEFFICIENT    = 30000;
-    static constexpr int CHECK_COEFFICIENT   = 20000;
-    static constexpr int EVASION_COEFFICIENT = 8000;
-    static constexpr int CAPTURE_COEFFICIENT = 6000;
-    static constexpr int QUIET_COEFFICIENT   = 5000;
-    static constexpr int move_arround        = 50;
-
-    int DetermineEvasionType(Position& pos, Move& m, const bool debug = false);
-
-    int DetermineCaptureType(Position& pos, Move& m, const bool debug = false);
-
-    int DetermineQuiteType(Position& pos, Move& m, const bool debug = false);
-
-    int DetermineScore(Position& pos, Move& m, Move& ttm);
+   private:
+    int16_t table[COLOR_NB][SQUARE_NB][SQUARE_NB] = {};
 };
 
-template<GenType genType = LEGAL>
-class CustomMovePicker: public MoveSorter {
+// The quiet move that last refuted a move, by [piece][to] of the refuted move
+using CounterMoveHistory = Move[PIECE_NB][SQUARE_NB];
+
+// Staged move picker for the main search. Moves are handed out one at a time
+// by next_move(), stage by stage:
+//   1. the TT move, validated with pseudo_legal() instead of a generation
+//   2. captures that do not lose material by SEE, by MVV-LVA
+//   3. the killer moves of this ply and the countermove of the previous move
+//   4. quiet moves, by butterfly history and threat escape/en prise tests
+//   5. the captures that lose material by SEE
+// In check the evasions are handed out after the TT move instead. A stage is
+// generated and scored only when it is reached, so a cutoff on the TT move or
+// an early capture saves the generation and scoring of everything else.
+// Moves are pseudo legal, the caller checks legal() before playing them.
+class CustomMovePicker {
+    enum Stage {
+        MAIN_TT,
+        CAPTURE_INIT,
+        GOOD_CAPTURE,
+        REFUTATION,
+        QUIET_INIT,
+        QUIET,
+        BAD_CAPTURE,
+
+        EVASION_TT,
+        EVASION_INIT,
+        EVASION
+    };
 
    public:
-    CustomMovePicker(Position& pos, TranspositionTable* tt) :
-        m_pos(pos),
-        m_tt(tt),
-        list(MoveList<genType>(pos)) {
-        for (auto& move : list)
-        {
-            auto [ttHit, ttData, ttWriter] = m_tt->probe(pos.key());
-            move.value                     = DetermineScore(pos, move, ttData.move);
-        }
-        partial_insertion_sort(list.begin(), list.end(), std::numeric_limits<int>::min());
-    }
+    CustomMovePicker(const Position&         pos,
+                     Move                    ttm,
+                     const Move*             killers,
+                     const ButterflyHistory* mh,
+                     Move                    cm);
+    CustomMovePicker(const CustomMovePicker&)            = delete;
+    CustomMovePicker& operator=(const CustomMovePicker&) = delete;
 
-    ExtMove* begin() { return list.begin(); }
+    Move next_move();
 
-    ExtMove* end() { return list.end(); }
+    // Late move pruning: the remaining quiet moves are neither generated nor
+    // returned, captures still are. Evasions are not affected.
+    void skip_quiet_moves() { skipQuiets = true; }
 
-    size_t size() { return list.size(); }
+    // Number of moves scored so far, for the picker benchmark
+    size_t scored() const { return scoredCount; }
 
-    ExtMove* pickfirst() { return list.pickfirst(); }
-    ExtMove* picklast() { return list.pickfirst() + (size() - 1); }
-
-    ExtMove* pick() { return list.pick(); }
+   private:
+    template<GenType Type>
+    void score();
+    bool good_capture(const ExtMove& m) const;
+    void partial_insertion_sort(ExtMove* begin, ExtMove* end, int limit);
+
+    const Position&         pos;
+    const ButterflyHistory* mainHistory;
+    Move                    ttMove;
+    ExtMove                 refutations[3];
+    ExtMove *               cur, *endMoves, *endBadCaptures;
+    int                     stage;
+    size_t                  scoredCount = 0;
+    bool                    skipQuiets  = false;
+    ExtMove                 moves[MAX_MOVES];
+};
 
+// Move list for the quiescence search: captures, or evasions when in check,
+// generated at once and sorted. At the first qsearch ply the quiet checks are
+// added after the captures. The TT move comes first, then checking captures,
+// then the other captures by MVV-LVA. Evasions that keep the moved piece safe
+// by SEE go before the ones that lose it.
+class CustomMovePickerForQSearch {
 
     void partial_insertion_sort(ExtMove* begin, ExtMove* end, int limit) {
 
@@ -148,58 +124,36 @@ class CustomMovePicker: public MoveSorter {
             }
     }
 
-   private:
-    Position&           m_pos;
-    TranspositionTable* m_tt;
-    MoveList<genType>   list;
-    ExtMove*            m_cur;
-};
+    static constexpr int HASH_COEFFICIENT    = 30000;
+    static constexpr int CHECK_COEFFICIENT   = 20000;
+    static constexpr int EVASION_COEFFICIENT = 8000;
+    static constexpr int CAPTURE_COEFFICIENT = 6000;
 
-class CustomMovePickerForQSearch: public MoveSorter {
+    int score(const Position& pos, Move m, Move ttm) const {
+        if (m == ttm)
+            return HASH_COEFFICIENT;
 
-    void partial_insertion_sort(ExtMove* begin, ExtMove* end, int limit) {
+        Piece captured = pos.piece_on(m.to_sq());
+        int   mvvLva   = 7 * int(PieceValue[captured]) - int(PieceValue[pos.moved_piece(m)]) / 8;
+        if (pos.checkers())
+            return EVASION_COEFFICIENT + (captured ? mvvLva : pos.see_ge(m) ? 0 : -2 * mvvLva);
 
-        for (ExtMove *sortedEnd = begin, *p = begin + 1; p < end; ++p)
-            if (p->value >= limit)
-            {
-                ExtMove tmp = *p, *q;
-                *p          = *++sortedEnd;
-                for (q = sortedEnd; q != begin && *(q - 1) < tmp; --q)
-                    *q = *(q - 1);
-                *q = tmp;
-            }
+        // Quiet checks stay behind the captures
+        if (!pos.capture_stage(m))
+            return 0;
+        return CAPTURE_COEFFICIENT + mvvLva + (pos.gives_check(m) ? CHECK_COEFFICIENT : 0);
     }
 
    public:
-    CustomMovePickerForQSearch(Position& pos, TranspositionTable* tt) :
-        m_tt(tt) {
-        if (pos.checkers())
-        {
-            for (auto& move : MoveList<EVASIONS>(pos))
-            {
-                if (move.is_ok())
-                    moves[i++] = move;
-            }
-        }
-        else
-        {
-            /* for (auto& move : MoveList<QUIET_CHECKS>(pos))
-            {
-                if (move.is_ok())
-                    moves[i++] = move;
-            } */
-            for (auto& move : MoveList<CAPTURES>(pos))
-            {
-                if (move.is_ok())
-                    moves[i++] = move;
-            }
-        }
-        for (auto& move : *this)
-        {
-            auto [ttHit, ttData, ttWriter] = m_tt->probe(pos.key());
+    CustomMovePickerForQSearch(const Position& pos, Move ttm, bool withChecks) {
+        ExtMove* last = pos.checkers() ? generate<EVASIONS>(pos, moves)
+                                       : generate<CAPTURES>(pos, moves);
+        if (withChecks && !pos.checkers())
+            last = generate<QUIET_CHECKS>(pos, last);
+        i = last - moves;
 
-            move.value = DetermineScore(pos, move, ttData.move);
-        }
+        for (auto& move : *this)
+            move.value = score(pos, move, ttm);
         partial_insertion_sort(this->begin(), this->end(), std::numeric_limits<int>::min());
     }
 
@@ -212,8 +166,6 @@ class CustomMovePickerForQSearch: public MoveSorter {
     int size() { return i; }
 
    private:
-    int                 i             = 0;
-    size_t              current_depth = 0;
-    TranspositionTable* m_tt;
+    int i = 0;
 };
 }
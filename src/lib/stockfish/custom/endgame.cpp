@@ -0,0 +1,89 @@
+#include "endgame.h"
+#include "pesto_evaluate.h"
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace Stockfish::Endgames {
+
+namespace {
+
+std::unordered_map<Key, Endgame> registry;
+
+// Drives a king to the edge, where it has the fewest squares
+int push_to_edge(Square s) {
+    int rd = edge_distance(rank_of(s)), fd = edge_distance(file_of(s));
+    return 90 - (7 * fd * fd / 2 + 7 * rd * rd / 2);
+}
+
+int push_close(Square s1, Square s2) { return 140 - 20 * distance(s1, s2); }
+int push_away(Square s1, Square s2) { return 120 - push_close(s1, s2); }
+
+Value to_side_to_move(const Position& pos, Color strongSide, int v) {
+    return Value(strongSide == pos.side_to_move() ? v : -v);
+}
+
+// Rook against a lone piece. Taking that piece leaves a bare king, so the
+// rook goes after a piece cut off from its king while our king closes in.
+Value KRKX(const Position& pos, Color strongSide) {
+    Color  weakSide   = ~strongSide;
+    Square strongKing = pos.square<KING>(strongSide);
+    Square weakKing   = pos.square<KING>(weakSide);
+    Square weakPiece  = lsb(pos.pieces(weakSide) ^ square_bb(weakKing));
+
+    int v = eg_value[ROOK] - eg_value[type_of(pos.piece_on(weakPiece))]
+          + push_away(weakKing, weakPiece) + push_to_edge(weakKing) / 2
+          + push_close(strongKing, weakKing) / 2;
+    return to_side_to_move(pos, strongSide, v);
+}
+
+// One piece each of the same kind, neither side can make progress alone
+int scale_even(const Position&, Color) { return ScaleFactorNormal / 4; }
+
+// The code names the pieces with the chess letters: N is the horse, B the
+// alfil, Q the ferz. Both colors are registered as the strong side.
+void add(const std::string& code, EndgameFn eval, ScaleFn scale) {
+    for (Color c : {WHITE, BLACK})
+    {
+        StateInfo st;
+        Position  pos;
+        pos.set(code, c, &st, false);
+        registry[pos.material_key()] = {eval, scale, c};
+    }
+}
+
+void init() {
+    add("KRKQ", KRKX, nullptr);
+    add("KRKN", KRKX, nullptr);
+    add("KRKB", KRKX, nullptr);
+    add("KRKP", KRKX, nullptr);
+
+    add("KRKR", nullptr, scale_even);
+    add("KQKQ", nullptr, scale_even);
+    add("KNKN", nullptr, scale_even);
+    add("KBKB", nullptr, scale_even);
+}
+
+}
+
+const Endgame* probe(Key materialKey) {
+    static std::once_flag initialized;
+    std::call_once(initialized, init);
+
+    auto it = registry.find(materialKey);
+    return it != registry.end() ? &it->second : nullptr;
+}
+
+// The weak side loses as soon as it is to move without a capture of our last
+// piece, see GameEndDetector::BareKing. Keep the material and corner the king.
+Value KXK(const Position& pos, Color strongSide) {
+    Square strongKing = pos.square<KING>(strongSide);
+    Square weakKing   = pos.square<KING>(~strongSide);
+
+    int v = KnownWin + 50 * pos.count<ALL_PIECES>(strongSide) + push_to_edge(weakKing)
+          + push_close(strongKing, weakKing);
+    return to_side_to_move(pos, strongSide, v);
+}
+
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "../stockfish_position.h"
+
+namespace Stockfish {
+
+// Above any positional score, below the mate scores
+constexpr Value KnownWin = 10000;
+
+// The evaluation is scaled by factor / ScaleFactorNormal
+constexpr int ScaleFactorNormal = 64;
+
+// Score of a known ending, from the side to move's point of view
+using EndgameFn = Value (*)(const Position& pos, Color strongSide);
+// Scale factor of the normal evaluation when strongSide is ahead
+using ScaleFn = int (*)(const Position& pos, Color strongSide);
+
+namespace Endgames {
+
+struct Endgame {
+    EndgameFn evaluate;
+    ScaleFn   scale;
+    Color     strongSide;
+};
+
+// The ending registered for a material key, nullptr if there is none. The
+// registry is built on the first call.
+const Endgame* probe(Key materialKey);
+
+// Any material against a bare king, not tied to one material key
+Value KXK(const Position& pos, Color strongSide);
+
+}
+}
@@ -0,0 +1,28 @@
+#include "eval_cache.h"
+
+#include <bit>
+
+namespace Stockfish {
+
+// Rounds down to a power of two slots
+void EvalCache::resize(size_t mb) {
+    size_t count = mb * 1024 * 1024 / sizeof(uint64_t);
+    if (count == 0)
+    {
+        slots.reset();
+        mask = 0;
+        return;
+    }
+
+    count = std::bit_floor(count);
+    slots.reset(new std::atomic<uint64_t>[count]);
+    mask = count - 1;
+    clear();
+}
+
+void EvalCache::clear() {
+    for (size_t i = 0; mask && i <= mask; ++i)
+        slots[i].store(0, std::memory_order_relaxed);
+}
+
+}
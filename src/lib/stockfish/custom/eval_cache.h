@@ -0,0 +1,46 @@
+#pragma once
+
+#include "../types.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace Stockfish {
+
+// Static evaluations by position key, shared by all search threads. Every
+// slot is one 64 bit word: the upper 48 key bits and the 16 bit evaluation,
+// so a slot is read and written with a single relaxed atomic and needs no
+// lock. The index takes the low key bits, which covers the 16 bits not
+// stored for any table of 64K slots or more. Zero size disables the cache.
+class EvalCache {
+   public:
+    static constexpr size_t DefaultSizeMb = 4;
+
+    EvalCache() { resize(DefaultSizeMb); }
+
+    void resize(size_t mb);
+    void clear();
+
+    bool enabled() const { return mask != 0; }
+
+    bool probe(Key key, Value& v) const {
+        uint64_t data = slots[key & mask].load(std::memory_order_relaxed);
+        if ((data ^ key) >> 16)
+            return false;
+        v = Value(int16_t(data & 0xFFFF));
+        return true;
+    }
+
+    void store(Key key, Value v) {
+        slots[key & mask].store((key & ~uint64_t(0xFFFF)) | uint16_t(int16_t(v)),
+                                std::memory_order_relaxed);
+    }
+
+   private:
+    std::unique_ptr<std::atomic<uint64_t>[]> slots;
+    size_t                                   mask = 0;
+};
+
+}
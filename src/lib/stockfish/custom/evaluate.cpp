@@ -1,55 +1,56 @@
 #include "evaluate.h"
 #include "game_over_check.h"
+#include "material.h"
+#include "pawns.h"
 #include "pesto_evaluate.h"
+#include <atomic>
 #include <limits>
 
 namespace Stockfish {
 
-struct MobilityCalculator {
-    int movecount;
-    int mobility;
+namespace {
 
-    inline MobilityCalculator& operator()(const Stockfish::Position& pos) {
+// Flipped by the UCI thread while search threads read them
+std::atomic<bool> useMobility = true;
+std::atomic<bool> useEndgames = true;
 
-        if (pos.st->previous != nullptr && pos.st->previous->movesize != 0)
-        {
-            otherSideMobilityCount = pos.st->previous->movesize;
-        }
-        else
-        {
-            const auto [cmbegin, cmcount_] =
-              all_possible_counter_moves(pos, *MoveList<LEGAL>(pos).begin());
-            otherSideMobilityCount = cmcount_;
-        }
+// Per safe square reachable, by piece type. Larger weights lose the bare king
+// conversions of the puzzle tests. The king's term is switched off: at 1 a
+// centralising king trades 4k3/8/8/8/1n6/3N4/8/R3K3 b into a bare king draw.
+constexpr int MobilityWeight[PIECE_TYPE_NB] = {0, 0, 2, 1, 1, 2, 0};
 
-        if (pos.side_to_move() == WHITE)
-        {
-            movecount_w = pos.st->movesize < 0 ? MoveList<LEGAL>(pos).size() : pos.st->movesize;
-            movecount_b = otherSideMobilityCount;
-            movecount   = movecount_w;
-        }
-        else
-        {
-            movecount_b = pos.st->movesize < 0 ? MoveList<LEGAL>(pos).size() : pos.st->movesize;
-            movecount_w = otherSideMobilityCount;
-            movecount   = movecount_b;
-        }
-        mobility = (movecount_w - movecount_b) * MobilityW;
-        return (*this);
-    }
+// Squares a piece type attacks, from the node's attack map. A square two
+// pieces of the type reach counts once.
+template<PieceType Pt>
+int mobility(const Position& pos, Color us, Bitboard safe) {
+    if constexpr (MobilityWeight[Pt] == 0)
+        return 0;
+    else
+        return popcount(pos.attacks_by<Pt>(us) & safe) * MobilityWeight[Pt];
+}
 
-   private:
-    int otherSideMobilityCount;
-    int movecount_w;
-    int movecount_b;
-};
+// Squares the pieces of us attack that are neither ours nor covered by an
+// enemy pawn, weighted by piece type. The attack map is a cache of the
+// position, built on first use: a score from the eval cache leaves it to the
+// move picker or legal(), and the maps come out the same either way.
+template<Color Us>
+int mobility(const Position& pos, const Pawns::Entry& pe) {
+    Bitboard safe = ~pos.pieces(Us) & ~pe.pawnAttacks[~Us];
+    return mobility<KNIGHT>(pos, Us, safe) + mobility<BISHOP>(pos, Us, safe)
+         + mobility<QUEEN>(pos, Us, safe) + mobility<ROOK>(pos, Us, safe)
+         + mobility<KING>(pos, Us, safe);
+}
 
+}
 
-int16_t evaluate(Stockfish::Position pos) {
-    //MobilityCalculator mobCalculator;
-    //auto               mobCalculatorRes = mobCalculator(pos);
+void set_mobility(bool enabled) { useMobility.store(enabled, std::memory_order_relaxed); }
+bool mobility_enabled() { return useMobility.load(std::memory_order_relaxed); }
+void set_endgames(bool enabled) { useEndgames.store(enabled, std::memory_order_relaxed); }
+bool endgames_enabled() { return useEndgames.load(std::memory_order_relaxed); }
 
-    auto gameresult = pos.gameEndDetector.Analyse(pos);
+int16_t evaluate(const Stockfish::Position& pos, Pawns::Table* pawns, Material::Table* material) {
+    // No move generation here, mate and stalemate are left to the search
+    auto gameresult = pos.known_game_end();
     if (gameresult != GameEndDetector::None)
     {
         if (gameresult == GameEndDetector::Draw)
@@ -72,9 +73,35 @@ int16_t evaluate(Stockfish::Position pos) {
         }
     }
 
+    Material::Entry        localMe;
+    const Material::Entry* me =
+      material ? material->probe(pos) : (Material::compute(pos, localMe), &localMe);
+    assert(me->gamePhase == pos.st->gamePhase);
+
+    const bool endgames = endgames_enabled();
+    if (endgames && me->specialized_eval_exists())
+        return me->evaluate(pos);
+
     int materialScore = eval_PeSTO(pos);
+    assert(materialScore == eval_PeSTO_full(pos));
+
+    Pawns::Entry        localPe;
+    const Pawns::Entry* pe =
+      pawns ? pawns->probe(pos) : (Pawns::compute(pos, localPe), &localPe);
 
-    int ret = materialScore /* + mobCalculatorRes.mobility */;
+    int ret = materialScore
+            + tapered(pe->mg, pe->eg + me->imbalance, me->gamePhase, pos.side_to_move());
+    if (mobility_enabled())
+    {
+        int mob = mobility<WHITE>(pos, *pe) - mobility<BLACK>(pos, *pe);
+        ret += pos.side_to_move() == WHITE ? mob : -mob;
+    }
+
+    if (endgames)
+    {
+        Color strongSide = ret > 0 ? pos.side_to_move() : ~pos.side_to_move();
+        ret              = ret * me->scale_factor(pos, strongSide) / ScaleFactorNormal;
+    }
     assert(ret == ((int16_t) ret));
 
     return ret;
@@ -3,7 +3,26 @@
 #include "../stockfish_position.h"
 
 namespace Stockfish {
-int16_t evaluate(Stockfish::Position pos);
+namespace Pawns {
+class Table;
+}
+namespace Material {
+class Table;
+}
+
+// Static evaluation for the side to move. The pawn structure and material
+// terms come from the given hash tables, or are computed on the spot without.
+int16_t evaluate(const Stockfish::Position& pos,
+                 Pawns::Table*              pawns    = nullptr,
+                 Material::Table*           material = nullptr);
+
+// The mobility term is on by default, switched off for A/B comparisons. Not
+// to be changed while a search runs.
+void set_mobility(bool enabled);
+bool mobility_enabled();
+// The same for the known endings of the material table
+void set_endgames(bool enabled);
+bool endgames_enabled();
 namespace Testing {
 int get_table_value_mg(Stockfish::Piece pc, Stockfish::Square sq);
 }
@@ -3,53 +3,33 @@
 
 namespace Stockfish {
 GameEndDetector::GameEnd GameEndDetector::Analyse(const Position& pos) const {
-    auto curkey = pos.key();
-    if (lastAnalysisKey == curkey)
-    {
-        return lastAnalysisResult;
-    }
+    return pos.game_end();
+}
 
-    lastAnalysisKey      = curkey;
-    lastAnalysisResult   = None;
-    auto moves           = MoveList<LEGAL>(pos);
-    auto our_piece_count = pos.count<ALL_PIECES>(pos.side_to_move());
-    if (moves.size() == 0)
-    {
-        if (pos.side_to_move() == WHITE)
-        {
-            lastAnalysisResult = BlackWin;
-        }
-        else
-        {
-            lastAnalysisResult = WhiteWin;
-        }
-    }
-    else if (our_piece_count == 1)  // only king of us left in the board
-    {
-        size_t opponent_piece_count = pos.count<ALL_PIECES>(~pos.side_to_move());
+GameEndDetector::GameEnd GameEndDetector::BareKing(const Position& pos) {
+    Color us = pos.side_to_move();
+    if (pos.count<ALL_PIECES>(us) != 1)  // only king of us left in the board
+        return None;
 
-        if (opponent_piece_count == 1)
-        {
-            lastAnalysisResult = Draw;
-        }
-        else if (opponent_piece_count == 2)
-        {
-            if (KingCanCaptureLastOpponentPiece(pos))
-                lastAnalysisResult = Draw;
-            else
-                lastAnalysisResult = pos.side_to_move() == WHITE ? BlackWin : WhiteWin;
-        }
-        else  // if (opponent_piece_count > 2)
-        {
-            lastAnalysisResult = pos.side_to_move() == WHITE ? BlackWin : WhiteWin;
-        }
-    }
-    return lastAnalysisResult;
+    GameEnd lost                 = us == WHITE ? BlackWin : WhiteWin;
+    int     opponent_piece_count = pos.count<ALL_PIECES>(~us);
+
+    if (opponent_piece_count == 1)
+        return Draw;
+    if (opponent_piece_count > 2 || !KingCanCaptureLastOpponentPiece(pos))
+        return lost;
+
+    // Taking the last piece draws, unless our king has no legal move at all
+    Square   ksq     = pos.square<KING>(us);
+    Bitboard targets = attacks_bb<KING>(ksq) & ~pos.pieces(us);
+    while (targets)
+        if (pos.legal(Move(ksq, pop_lsb(targets))))
+            return Draw;
+    return lost;
 }
 
 void GameEndDetector::DumpGameEnd(const Stockfish::Position& pos) {
-    Analyse(pos);
-    switch (lastAnalysisResult)
+    switch (Analyse(pos))
     {
     case None :
         break;
@@ -65,7 +45,7 @@ void GameEndDetector::DumpGameEnd(const Stockfish::Position& pos) {
     }
 }
 
-bool GameEndDetector::KingCanCaptureLastOpponentPiece(const Stockfish::Position& pos) const {
+bool GameEndDetector::KingCanCaptureLastOpponentPiece(const Stockfish::Position& pos) {
     auto our_pieces               = pos.pieces(pos.side_to_move());
     auto our_king                 = pos.pieces(KING) & our_pieces;
     auto opponent_pieces          = pos.pieces(~pos.side_to_move());
@@ -16,13 +16,14 @@ class GameEndDetector {
         Draw
     };
 
+    // The exact result, same as Position::game_end()
     GameEnd Analyse(const Stockfish::Position& pos) const;
     void    DumpGameEnd(const Stockfish::Position& pos);
-    bool    KingCanCaptureLastOpponentPiece(const Stockfish::Position& pos) const;
 
-   private:
-    mutable Stockfish::Key lastAnalysisKey;
-    mutable GameEnd        lastAnalysisResult;
+    // The bare king rule for the side to move, from the piece counts and at
+    // most eight king moves. Mate and stalemate are not looked at.
+    static GameEnd BareKing(const Stockfish::Position& pos);
+    static bool    KingCanCaptureLastOpponentPiece(const Stockfish::Position& pos);
 };
 
 }
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "../types.h"
+
+#include <cstdint>
+#include <memory>
+
+namespace Stockfish {
+
+// Direct mapped cache of evaluation entries, indexed by the low bits of a key
+// and verified by the full key stored in the entry. Not thread safe, every
+// search thread owns its tables.
+template<typename Entry, size_t Size>
+class HashTable {
+    static_assert((Size & (Size - 1)) == 0, "Size must be a power of 2");
+
+   public:
+    HashTable() :
+        entries(new Entry[Size]()) {}
+
+    // The cached entry of key, fill(entry) computes it on a miss
+    template<typename Fill>
+    Entry* probe(Key key, Fill&& fill) {
+        Entry& e = entries[key & (Size - 1)];
+
+        ++probeCount;
+        if (e.key == key)
+        {
+            ++hitCount;
+            return &e;
+        }
+
+        fill(e);
+        return &e;
+    }
+
+    uint64_t probes() const { return probeCount; }
+    uint64_t hits() const { return hitCount; }
+    double   hit_rate() const { return probeCount ? double(hitCount) / probeCount : 0.0; }
+
+   private:
+    std::unique_ptr<Entry[]> entries;
+    uint64_t                 probeCount = 0;
+    uint64_t                 hitCount   = 0;
+};
+
+}
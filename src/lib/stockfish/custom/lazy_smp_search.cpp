@@ -0,0 +1,169 @@
+#include "lazy_smp_search.h"
+
+#include <map>
+
+namespace Stockfish {
+
+template<bool HaveTimeOut>
+lazy_smp_search<HaveTimeOut>::lazy_smp_search(TranspositionTable*       tt,
+                                              Position&                 pos,
+                                              size_t                    threadCount,
+                                              std::chrono::milliseconds t) :
+    m_pos(pos),
+    mainSearch(tt, pos, t, 0) {
+    for (size_t i = 1; i < threadCount; ++i)
+    {
+        auto& h   = helpers.emplace_back(std::make_unique<helper>());
+        h->worker = std::make_unique<search<true>>(tt, h->pos, std::chrono::seconds(3600), i);
+    }
+}
+
+template<bool HaveTimeOut>
+Move lazy_smp_search<HaveTimeOut>::iterative_deepening(int d) {
+    LimitsType limits;
+    limits.depth = d;
+    return iterative_deepening(limits);
+}
+
+template<bool HaveTimeOut>
+Move lazy_smp_search<HaveTimeOut>::iterative_deepening(const LimitsType& limits) {
+    start(limits);
+    return wait();
+}
+
+// The helpers copy the root before any thread moves on it, and the main thread
+// starts first so the TT generation is bumped before a helper stores an entry.
+template<bool HaveTimeOut>
+void lazy_smp_search<HaveTimeOut>::start(const LimitsType& limits) {
+    for (auto& h : helpers)
+    {
+        h->pos       = m_pos;
+        h->rootState = *m_pos.st;
+        h->pos.st    = &h->rootState;
+    }
+
+    mainSearch.start_parallel_root(limits);
+
+    LimitsType helperLimits;
+    helperLimits.depth = limits.depth;
+    for (auto& h : helpers)
+        h->worker->start_parallel_root(helperLimits);
+}
+
+template<bool HaveTimeOut>
+Move lazy_smp_search<HaveTimeOut>::wait() {
+    mainSearch.block_for_search();
+
+    for (auto& h : helpers)
+        h->worker->stop();
+    for (auto& h : helpers)
+        h->worker->block_for_search();
+
+    pick_best();
+    return bestMove;
+}
+
+template<bool HaveTimeOut>
+uint64_t lazy_smp_search<HaveTimeOut>::nodes_searched() const {
+    uint64_t sum = mainSearch.nodes_searched();
+    for (auto& h : helpers)
+        sum += h->worker->nodes_searched();
+    return sum;
+}
+
+template<bool HaveTimeOut>
+void lazy_smp_search<HaveTimeOut>::set_eval_cache(EvalCache* cache) {
+    mainSearch.set_eval_cache(cache);
+    for (auto& h : helpers)
+        h->worker->set_eval_cache(cache);
+}
+
+template<bool HaveTimeOut>
+uint64_t lazy_smp_search<HaveTimeOut>::eval_cache_probes() const {
+    uint64_t sum = mainSearch.eval_cache_probes();
+    for (auto& h : helpers)
+        sum += h->worker->eval_cache_probes();
+    return sum;
+}
+
+template<bool HaveTimeOut>
+uint64_t lazy_smp_search<HaveTimeOut>::eval_cache_hits() const {
+    uint64_t sum = mainSearch.eval_cache_hits();
+    for (auto& h : helpers)
+        sum += h->worker->eval_cache_hits();
+    return sum;
+}
+
+template<bool HaveTimeOut>
+uint64_t lazy_smp_search<HaveTimeOut>::tt_probes() const {
+    uint64_t sum = mainSearch.tt_probes();
+    for (auto& h : helpers)
+        sum += h->worker->tt_probes();
+    return sum;
+}
+
+template<bool HaveTimeOut>
+uint64_t lazy_smp_search<HaveTimeOut>::tt_hits() const {
+    uint64_t sum = mainSearch.tt_hits();
+    for (auto& h : helpers)
+        sum += h->worker->tt_hits();
+    return sum;
+}
+
+// Every thread votes for its best root move, weighted by its completed depth and
+// by how far its score is above the worst one. Proven mates override the vote.
+template<bool HaveTimeOut>
+void lazy_smp_search<HaveTimeOut>::pick_best() {
+    struct candidate {
+        Move  move;
+        Value score;
+        Depth depth;
+    };
+    std::vector<candidate> candidates;
+
+    auto collect = [&](const RootMoves& rms, Depth depth) {
+        if (!rms.empty() && depth > 0)
+            candidates.push_back({rms[0].pv[0], rms[0].score, depth});
+    };
+    collect(mainSearch.root_moves(), mainSearch.completedDepth);
+    for (auto& h : helpers)
+        collect(h->worker->root_moves(), h->worker->completedDepth);
+
+    bestMove       = mainSearch.picked_move();
+    bestScore      = mainSearch.root_moves().empty() ? -VALUE_INFINITE
+                                                     : mainSearch.root_moves()[0].score;
+    completedDepth = mainSearch.completedDepth;
+    if (candidates.empty())
+        return;
+
+    Value minScore = VALUE_INFINITE;
+    for (auto& c : candidates)
+        minScore = std::min(minScore, c.score);
+
+    std::map<Move, int64_t> votes;
+    for (auto& c : candidates)
+        votes[c.move] += int64_t(c.score - minScore + 14) * c.depth;
+
+    const candidate* best = &candidates[0];
+    for (auto& c : candidates)
+    {
+        if (std::abs(best->score) >= VALUE_MATE_IN_MAX_PLY)
+        {
+            if (c.score > best->score)
+                best = &c;
+        }
+        else if (c.score >= VALUE_MATE_IN_MAX_PLY
+                 || (votes[c.move] > votes[best->move]
+                     || (votes[c.move] == votes[best->move] && c.depth > best->depth)))
+            best = &c;
+    }
+
+    bestMove       = best->move;
+    bestScore      = best->score;
+    completedDepth = std::max(completedDepth, best->depth);
+}
+
+template class lazy_smp_search<true>;
+
+template class lazy_smp_search<false>;
+}
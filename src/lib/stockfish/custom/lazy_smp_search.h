@@ -0,0 +1,72 @@
+#pragma once
+
+#include "custom_search.h"
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace Stockfish {
+
+// Lazy SMP driver. The main thread runs search<HaveTimeOut> on the caller's
+// position, every helper runs a search<true> on its own Position copy with its
+// own Stack and root move list. All of them share the one TranspositionTable,
+// which is the only channel between threads. When the main search is done the
+// helpers are stopped and the best move is chosen by a depth weighted vote.
+template<bool HaveTimeOut = true>
+class lazy_smp_search {
+   public:
+    lazy_smp_search(TranspositionTable*       tt,
+                    Position&                 pos,
+                    size_t                    threadCount,
+                    std::chrono::milliseconds t = std::chrono::seconds(3600));
+
+    Move iterative_deepening(int d = 20);
+
+    // Only the main thread manages time, the helpers run until it is done
+    Move iterative_deepening(const LimitsType& limits);
+
+    // iterative_deepening() split in two for callers that keep working while
+    // the threads search. start() returns at once, a stop() issued any time
+    // after it ends the search, and wait() blocks until the main thread is
+    // done, then stops the helpers and picks the move.
+    void start(const LimitsType& limits);
+    Move wait();
+    void stop() { mainSearch.stop(); }
+
+    void on_iteration(IterationCallback cb) { mainSearch.on_iteration(std::move(cb)); }
+
+    // Shared by all threads like the TT
+    void set_eval_cache(EvalCache* cache);
+
+    Move     picked_move() const { return bestMove; }
+    Value    picked_move_score() const { return bestScore; }
+    uint64_t nodes_searched() const;
+    uint64_t eval_cache_probes() const;
+    uint64_t eval_cache_hits() const;
+    uint64_t tt_probes() const;
+    uint64_t tt_hits() const;
+    size_t   thread_count() const { return helpers.size() + 1; }
+
+    Depth completedDepth = 0;
+
+   private:
+    // Helpers point their root StateInfo back into the caller's history, which
+    // they only read, so repetition detection still sees the whole game.
+    struct helper {
+        Position                      pos;
+        StateInfo                     rootState;
+        std::unique_ptr<search<true>> worker;
+    };
+
+    void pick_best();
+
+    Position&                            m_pos;
+    search<HaveTimeOut>                  mainSearch;
+    std::vector<std::unique_ptr<helper>> helpers;
+    Move                                 bestMove  = Move::none();
+    Value                                bestScore = -VALUE_INFINITE;
+};
+
+}
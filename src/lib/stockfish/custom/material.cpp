@@ -0,0 +1,49 @@
+#include "material.h"
+#include "pesto_evaluate.h"
+
+namespace Stockfish::Material {
+
+namespace {
+
+// Per piece more than the opponent. The bare king rule makes the number of
+// pieces count in the ending beyond their value.
+constexpr int PieceCountBonus = 8;
+
+}
+
+void compute(const Position& pos, Entry& e) {
+    e.key                = pos.material_key();
+    e.evaluationFunction = nullptr;
+    e.scalingFunction    = nullptr;
+    e.strongSide         = WHITE;
+    e.gamePhase          = 0;
+
+    // The same sum StateInfo::gamePhase keeps, gamephaseInc is zero on the
+    // total counts of both colors
+    for (int pc = 0; pc < PIECE_NB; ++pc)
+        e.gamePhase += gamephaseInc[pc] * pos.pieceCount[pc];
+
+    e.imbalance =
+      PieceCountBonus * (pos.count<ALL_PIECES>(WHITE) - pos.count<ALL_PIECES>(BLACK));
+
+    for (Color c : {WHITE, BLACK})
+        if (pos.count<ALL_PIECES>(~c) == 1 && pos.count<ALL_PIECES>(c) > 1)
+        {
+            e.evaluationFunction = Endgames::KXK;
+            e.strongSide         = c;
+            return;
+        }
+
+    if (const Endgames::Endgame* eg = Endgames::probe(e.key))
+    {
+        e.evaluationFunction = eg->evaluate;
+        e.scalingFunction    = eg->scale;
+        e.strongSide         = eg->strongSide;
+    }
+}
+
+const Entry* Table::probe(const Position& pos) {
+    return HashTable::probe(pos.material_key(), [&](Entry& e) { compute(pos, e); });
+}
+
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "../stockfish_position.h"
+#include "endgame.h"
+#include "hash_table.h"
+
+namespace Stockfish::Material {
+
+// What the material alone says about a position: the game phase, an
+// imbalance term (white minus black, endgame weight) and a known ending's
+// evaluation or scale function
+struct Entry {
+    Key       key;
+    EndgameFn evaluationFunction;
+    ScaleFn   scalingFunction;
+    Color     strongSide;
+    int       gamePhase;
+    int       imbalance;
+
+    bool  specialized_eval_exists() const { return evaluationFunction != nullptr; }
+    Value evaluate(const Position& pos) const { return evaluationFunction(pos, strongSide); }
+
+    // Scale factor for the normal evaluation when us is ahead
+    int scale_factor(const Position& pos, Color us) const {
+        return scalingFunction ? scalingFunction(pos, us) : ScaleFactorNormal;
+    }
+};
+
+// Computes the entry of the material on the board, without any caching
+void compute(const Position& pos, Entry& e);
+
+// Entries by materialKey, one table per search thread
+class Table: public HashTable<Entry, 8192> {
+   public:
+    const Entry* probe(const Position& pos);
+};
+
+}
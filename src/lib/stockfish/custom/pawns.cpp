@@ -0,0 +1,87 @@
+#include "pawns.h"
+
+namespace Stockfish::Pawns {
+
+namespace {
+
+// Penalties per pawn, middlegame and endgame
+constexpr int DoubledMg  = 8;
+constexpr int DoubledEg  = 16;
+constexpr int IsolatedMg = 2;
+constexpr int IsolatedEg = 4;
+constexpr int BlockedMg  = 3;
+constexpr int BlockedEg  = 6;
+
+// Passed pawn bonus by relative rank. A pawn only promotes to a ferz, so the
+// bonus stays well below the chess values.
+constexpr int PassedMg[RANK_NB] = {0, 0, 2, 4, 8, 15, 25, 0};
+constexpr int PassedEg[RANK_NB] = {0, 0, 5, 10, 18, 30, 45, 0};
+
+constexpr Bitboard north_fill(Bitboard b) {
+    b |= b << 8;
+    b |= b << 16;
+    return b | b << 32;
+}
+
+constexpr Bitboard south_fill(Bitboard b) {
+    b |= b >> 8;
+    b |= b >> 16;
+    return b | b >> 32;
+}
+
+constexpr Bitboard adjacent(Bitboard b) { return shift<EAST>(b) | shift<WEST>(b); }
+
+template<Color Us>
+void evaluate(const Position& pos, Entry& e) {
+    constexpr Color     Them = ~Us;
+    constexpr Direction Down = pawn_push(Them);
+
+    Bitboard ours   = pos.pieces(Us, PAWN);
+    Bitboard theirs = pos.pieces(Them, PAWN);
+
+    // Squares ahead of a pawn, seen from its own side
+    auto ahead = [](Color c, Bitboard b) {
+        return c == WHITE ? north_fill(shift<NORTH>(b)) : south_fill(shift<SOUTH>(b));
+    };
+
+    Bitboard theirFront = ahead(Them, theirs);
+    Bitboard ourFiles   = north_fill(ours) | south_fill(ours);
+
+    e.pawnAttacks[Us]     = pawn_attacks_bb<Us>(ours);
+    e.pawnAttacksSpan[Us] = ahead(Us, e.pawnAttacks[Us]) | e.pawnAttacks[Us];
+    e.passedPawns[Us]     = ours & ~(theirFront | adjacent(theirFront));
+
+    Bitboard doubled  = ours & ahead(Them, ours);
+    Bitboard isolated = ours & ~adjacent(ourFiles);
+    Bitboard blocked  = ours & shift<Down>(ours | theirs);
+
+    int mg = -DoubledMg * popcount(doubled) - IsolatedMg * popcount(isolated)
+           - BlockedMg * popcount(blocked);
+    int eg = -DoubledEg * popcount(doubled) - IsolatedEg * popcount(isolated)
+           - BlockedEg * popcount(blocked);
+
+    for (Bitboard b = e.passedPawns[Us]; b;)
+    {
+        Rank r = relative_rank(Us, pop_lsb(b));
+        mg += PassedMg[r];
+        eg += PassedEg[r];
+    }
+
+    e.mg += Us == WHITE ? mg : -mg;
+    e.eg += Us == WHITE ? eg : -eg;
+}
+
+}
+
+void compute(const Position& pos, Entry& e) {
+    e.key = pos.pawn_key();
+    e.mg = e.eg = 0;
+    evaluate<WHITE>(pos, e);
+    evaluate<BLACK>(pos, e);
+}
+
+const Entry* Table::probe(const Position& pos) {
+    return HashTable::probe(pos.pawn_key(), [&](Entry& e) { compute(pos, e); });
+}
+
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "../stockfish_position.h"
+#include "hash_table.h"
+
+namespace Stockfish::Pawns {
+
+// Pawn structure terms of one pawn configuration, white minus black, and the
+// pawn attack sets the rest of the evaluation reuses
+struct Entry {
+    Key      key;
+    int      mg;
+    int      eg;
+    Bitboard passedPawns[COLOR_NB];
+    Bitboard pawnAttacks[COLOR_NB];
+    Bitboard pawnAttacksSpan[COLOR_NB];
+};
+
+// Computes the entry of the pawns on the board, without any caching
+void compute(const Position& pos, Entry& e);
+
+// Entries by pawnKey, one table per search thread
+class Table: public HashTable<Entry, 16384> {
+   public:
+    const Entry* probe(const Position& pos);
+};
+
+}
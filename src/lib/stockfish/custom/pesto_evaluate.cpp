@@ -1,5 +1,37 @@
 #include "pesto_evaluate.h"
+#include "../stockfish_position.h"
 
 namespace Stockfish {
-int get_table_value_mg(Stockfish::Piece pc, Stockfish::Square sq) { return mg_table[pc][sq]; }
+
+int tapered(int mgScore, int egScore, int gamePhase, Color us) {
+    int mgPhase = gamePhase;
+    if (mgPhase > 24)
+        mgPhase = 24; /* in case of early promotion */
+    int egPhase = 24 - mgPhase;
+    return (mgScore * mgPhase + egScore * egPhase) / 24 * (us == WHITE ? 1 : -1);
+}
+
+int eval_PeSTO(const Position& pos) {
+    return tapered(pos.st->mgPsq, pos.st->egPsq, pos.st->gamePhase, pos.side_to_move());
+}
+
+int eval_PeSTO_full(const Position& pos) {
+    int mg        = 0;
+    int eg        = 0;
+    int gamePhase = 0;
+
+    /* evaluate each piece */
+    auto pieces = pos.pieces();
+    while (pieces != 0)
+    {
+        Square sq = pop_lsb(pieces);
+        Piece  pc = pos.piece_on(sq);
+        mg += mg_psq(pc, sq);
+        eg += eg_psq(pc, sq);
+        gamePhase += gamephaseInc[pc];
+    }
+    return tapered(mg, eg, gamePhase, pos.side_to_move());
+}
+
+int get_table_value_mg(Piece pc, Square sq) { return mg_table[pc][sq]; }
 }
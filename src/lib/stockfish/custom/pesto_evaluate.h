@@ -1,17 +1,17 @@
 #pragma once
 
-#include "../stockfish_position.h"
+#include "../types.h"
 
 namespace Stockfish {
 // clang-format off
-const static inline int mg_value[8] = {0, 82, 337, 220, 477, 200, 0, 0};
-const static inline int eg_value[8] = {0, 94, 281, 200, 512, 180, 0, 0};
+inline constexpr int mg_value[8] = {0, 82, 337, 220, 477, 200, 0, 0};
+inline constexpr int eg_value[8] = {0, 94, 281, 200, 512, 180, 0, 0};
 
 /* piece/sq tables */
 /* values from Rofchade: http://www.talkchess.com/forum3/viewtopic.php?f=2&t=68311&start=19 */
-const static inline int null_table[64] = {};
+inline constexpr int null_table[64] = {};
 
-const static inline int mg_pawn_table[64] = {
+inline constexpr int mg_pawn_table[64] = {
   0,   0,  0,   0,   0,   0,  0,  0,
   98,  134, 61, 95,  68, 126, 34, -11,
   -6,  7,  26,  31,  65,  56, 25, -20,
@@ -22,7 +22,7 @@ const static inline int mg_pawn_table[64] = {
   0,   0,   0,  0,   0,  0,   0,  0,
 };
 
-const static inline int eg_pawn_table[64] = {
+inline constexpr int eg_pawn_table[64] = {
   0,  0,  0,  0,  0,  0, 0,  0,
   178, 173, 158, 134, 147, 132, 165, 187,
   94, 100, 85, 67, 56, 53,82, 84,
@@ -33,7 +33,7 @@ const static inline int eg_pawn_table[64] = {
   0,   0,   0,   0,   0,  0,   0,  0,
 };
 
-const static inline int mg_knight_table[64] = {
+inline constexpr int mg_knight_table[64] = {
   -167, -89, -34, -49, 61, -97, -15, -107,
   -73,  -41, 72,  36,  23,  62,  7,   -17,
   -47,  60,  37,  65,  84, 129, 73,44,
@@ -44,7 +44,7 @@ const static inline int mg_knight_table[64] = {
   -105, -21, -58, -33, -17, -28, -19, -23,
 };
 
-const static inline int eg_knight_table[64] = {
+inline constexpr int eg_knight_table[64] = {
   -58, -38, -13, -28, -31, -27, -63, -99, -25,
   -8,  -25, -2,  -9,  -25, -24, -52,
   -24, -20, 10,  9,   -1,  -9,  -19, -41,
@@ -55,7 +55,7 @@ const static inline int eg_knight_table[64] = {
   -29, -51, -23, -15, -22, -18, -50, -64,
 };
 
-const static inline int mg_bishop_table[64] = {
+inline constexpr int mg_bishop_table[64] = {
   -29, 4,  -82, -37, -25, -42, 7,  -8,
   -26, 16, -18, -13, 30,  59,  18,  -47,
   -16, 37, 43,  40,  35,  50,  37, -2,
@@ -66,7 +66,7 @@ const static inline int mg_bishop_table[64] = {
   -33, -3, -14, -21, -13, -12, -39, -21,
 };
 
-const static inline int eg_bishop_table[64] = {
+inline constexpr int eg_bishop_table[64] = {
   -14, -21, -11, -8, -7, -9, -17, -24,
   -8,  -4, 7,   -12, -3, -13, -4, -14,
   2,   -8,  0,   -1, -2, 6,  0,   4,
@@ -77,7 +77,7 @@ const static inline int eg_bishop_table[64] = {
   -23, -9, -23, -5,  -9, -16, -5, -17,
 };
 
-const static inline int mg_rook_table[64] = {
+inline constexpr int mg_rook_table[64] = {
   32,  42,  32,  51, 63, 9,  31, 43,
   27,  32,  58,  62,  80, 67, 26,  44,
   -5,  19,  26,  36, 17, 45, 61, 16,
@@ -88,7 +88,7 @@ const static inline int mg_rook_table[64] = {
   -19, -13, 1,   17,  16, 7,  -37, -26,
 };
 
-const static inline int eg_rook_table[64] = {
+inline constexpr int eg_rook_table[64] = {
   13, 10,  18, 15,  12, 12, 8, 5,
   11, 13, 13,  11, -3, 3, 8,  3,
   7,  7,   7,  5,   4,  -3,-5, -3,
@@ -99,21 +99,21 @@ const static inline int eg_rook_table[64] = {
   2, 3,  -1, -5, -13, 4,  -20,
 };
 
-/* const static inline int mg_queen_table[64] = {
+/* inline constexpr int mg_queen_table[64] = {
   -28, 0,   29, 12,  59, 44, 43, 45, -24, -39, -5,  1,   -16, 57,  28,  54,
   -13, -17, 7,  8,   29, 56, 47, 57, -27, -27, -16, -16, -1,  17,  -2,  1,
   -9,  -26, -9, -10, -2, -4, 3,  -3, -14, 2,   -11, -2,  -5,  2,   14,  5,
   -35, -8,  11, 2,   8,  15, -3, 1,  -1,  -18, -9,  10,  -15, -25, -31, -50,
 };
 
-const static inline int eg_queen_table[64] = {
+inline constexpr int eg_queen_table[64] = {
   -9,  22,  22,  27,  27,  19,  10,  20,  -17, 20,  32,  41,  58, 25,  30,  0,
   -20, 6,   9,   49,  47,  35,  19,  9,   3,   22,  24,  45,  57, 40,  57,  36,
   -18, 28,  19,  47,  31,  34,  39,  23,  -16, -27, 15,  6,   9,  17,  10,  5,
   -22, -23, -30, -16, -16, -23, -36, -32, -33, -28, -22, -43, -5, -32, -20, -41,
 }; */
 
-const static inline int mg_queen_table2[64] = {
+inline constexpr int mg_queen_table2[64] = {
   -29, 4,  -82, -37, -25, -42, 7,  -8,
   -26, 16, -18, -13, 30,  59,  18,  -47,
   -16, 37, 43,  40,  35,  50,  37, -2,
@@ -124,7 +124,7 @@ const static inline int mg_queen_table2[64] = {
   -33, -3, -14, -21, -13, -12, -39, -21,
 };
 
-const static inline int eg_queen_table2[64] = {
+inline constexpr int eg_queen_table2[64] = {
   -14, -21, -11, -8, -7, -9, -17, -24,
   -8,  -4, 7,   -12, -3, -13, -4, -14,
   2,   -8,  0,   -1, -2, 6,  0,   4,
@@ -134,7 +134,7 @@ const static inline int eg_queen_table2[64] = {
   -14, -18, -7,  -1, 4,  -9, -15, -27,
   -23, -9, -23, -5,  -9, -16, -5, -17,
 };
-const static inline int mg_king_table[64] = {
+inline constexpr int mg_king_table[64] = {
   -65, 23, 16,  -15, -56, -34, 2,   13,
   29,  -1,  -20, -7,  -8,  -4,  -38, -29,
   -9,  24, 2,   -16, -20, 6,   22,  -22,
@@ -145,7 +145,7 @@ const static inline int mg_king_table[64] = {
   -15, 36,  12,  -54, 8,   -28, 24,  14,
 };
 
-const static inline int eg_king_table[64] = {
+inline constexpr int eg_king_table[64] = {
   -74, -35, -18, -18, -11, 15, 4,  -17,
   -12, 17,  14,  17,  17,  38,  23,  11,
   10,  17,  23,  15,  20,  45, 44, 13,
@@ -156,15 +156,15 @@ const static inline int eg_king_table[64] = {
   -53, -34, -21, -11, -28, -14, -24, -43};
 
 
-const static inline int* mg_pesto_table[Stockfish::PIECE_TYPE_NB] = {
+inline constexpr const int* mg_pesto_table[Stockfish::PIECE_TYPE_NB] = {
   null_table,    mg_pawn_table,   mg_knight_table, mg_bishop_table,
   mg_rook_table, mg_queen_table2, mg_king_table,   null_table};
 
-const static inline int* eg_pesto_table[Stockfish::PIECE_TYPE_NB] = {
+inline constexpr const int* eg_pesto_table[Stockfish::PIECE_TYPE_NB] = {
   null_table,    eg_pawn_table,   eg_knight_table, eg_bishop_table,
   eg_rook_table, eg_queen_table2, eg_king_table,   null_table};
 
-const static inline int gamephaseInc[Stockfish::PIECE_NB] = {
+inline constexpr int gamephaseInc[Stockfish::PIECE_NB] = {
     0,
     0, 1, 1, 2, 4, 0,
     0,
@@ -175,62 +175,47 @@ const static inline int gamephaseInc[Stockfish::PIECE_NB] = {
     };
 
 // clang-format on
-inline int mg_table[Stockfish::PIECE_NB][64] = {};
-inline int eg_table[Stockfish::PIECE_NB][64] = {};
-
-inline void init_tables() {
-    static bool init = false;
-    if (init)
-        return;
-
-    for (Stockfish::PieceType p : {Stockfish::PAWN, Stockfish::ROOK, Stockfish::BISHOP,
-                                   Stockfish::KNIGHT, Stockfish::QUEEN, Stockfish::KING})
-    {
-        Stockfish::Piece pc = static_cast<Stockfish::Piece>(static_cast<int>(p));
-        for (Stockfish::Square sq = Stockfish::SQ_A1; sq <= Stockfish::SQ_H8; ++sq)
+
+struct PestoTables {
+    int mg[PIECE_NB][SQUARE_NB];
+    int eg[PIECE_NB][SQUARE_NB];
+};
+
+// Piece value plus square bonus for every piece and square, black reads the
+// tables rank flipped. Evaluated at compile time.
+constexpr PestoTables build_tables() {
+    PestoTables t{};
+    for (int p = PAWN; p <= KING; ++p)
+        for (int sq = SQ_A1; sq <= SQ_H8; ++sq)
         {
-            mg_table[pc][sq]     = mg_value[p] + mg_pesto_table[p][sq];
-            eg_table[pc][sq]     = eg_value[p] + eg_pesto_table[p][sq];
-            mg_table[pc + 8][sq] = mg_value[p] + mg_pesto_table[p][Stockfish::flip_rank(sq)];
-            eg_table[pc + 8][sq] = eg_value[p] + eg_pesto_table[p][Stockfish::flip_rank(sq)];
+            t.mg[p][sq]     = mg_value[p] + mg_pesto_table[p][sq];
+            t.eg[p][sq]     = eg_value[p] + eg_pesto_table[p][sq];
+            t.mg[p + 8][sq] = mg_value[p] + mg_pesto_table[p][sq ^ int(SQ_A8)];
+            t.eg[p + 8][sq] = eg_value[p] + eg_pesto_table[p][sq ^ int(SQ_A8)];
         }
-    }
-    init = true;
+    return t;
 }
 
-inline int eval_PeSTO(Stockfish::Position& pos) {
-    init_tables();
-    int mg[2]     = {};
-    int eg[2]     = {};
-    int gamePhase = 0;
-
-    mg[Stockfish::WHITE] = 0;
-    mg[Stockfish::BLACK] = 0;
-    eg[Stockfish::WHITE] = 0;
-    eg[Stockfish::BLACK] = 0;
-
-    /* evaluate each piece */
-    auto pieces = pos.pieces();
-    while (pieces != 0)
-    {
-        Stockfish::Square sq = Stockfish::pop_lsb(pieces);
-        Stockfish::Piece  pc = pos.board[sq];
-        assert(mg_table[pc][sq] != 0 && eg_table[pc][sq] != 0);
-        mg[Stockfish::color_of(pc)] += mg_table[pc][sq];
-        eg[Stockfish::color_of(pc)] += eg_table[pc][sq];
-        gamePhase += gamephaseInc[pc];
-    }
-
-    /* tapered eval */
-    int mgScore = mg[Stockfish::WHITE] - mg[Stockfish::BLACK];
-    int egScore = eg[Stockfish::WHITE] - eg[Stockfish::BLACK];
-    int mgPhase = gamePhase;
-    if (mgPhase > 24)
-        mgPhase = 24; /* in case of early promotion */
-    int egPhase = 24 - mgPhase;
-    return (mgScore * mgPhase + egScore * egPhase) / 24
-         * (pos.side_to_move() == Stockfish::WHITE ? 1 : -1);
-}
+inline constexpr PestoTables pesto    = build_tables();
+inline constexpr auto&       mg_table = pesto.mg;
+inline constexpr auto&       eg_table = pesto.eg;
+
+// Signed white minus black terms, the form StateInfo keeps them in
+constexpr int mg_psq(Piece pc, Square sq) { return pc & 8 ? -mg_table[pc][sq] : mg_table[pc][sq]; }
+constexpr int eg_psq(Piece pc, Square sq) { return pc & 8 ? -eg_table[pc][sq] : eg_table[pc][sq]; }
+
+class Position;
+
+// Blends white minus black middlegame and endgame scores by the game phase,
+// from the side to move's point of view
+int tapered(int mgScore, int egScore, int gamePhase, Color us);
+
+// Tapered PeSTO score for the side to move from the sums do_move() keeps up to
+// date in StateInfo.
+int eval_PeSTO(const Position& pos);
+
+// The same score recomputed from every piece on the board
+int eval_PeSTO_full(const Position& pos);
 
-int get_table_value_mg(Stockfish::Piece pc, Stockfish::Square sq);
+int get_table_value_mg(Piece pc, Square sq);
 }
@@ -0,0 +1,55 @@
+#include "timeman.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Stockfish {
+
+// Sudden death spends a small, slowly growing fraction of what is left, with
+// movestogo the remaining time is split over the moves to the next control.
+// The hard limit is a multiple of the optimum, but never more than a safe
+// share of the clock.
+void TimeManagement::init(const LimitsType& limits, Color us, int ply) {
+    if (!limits.use_time_management())
+    {
+        optimumTime = maximumTime = limits.movetime;
+        return;
+    }
+
+    TimePoint time = limits.time[us];
+    TimePoint inc  = limits.inc[us];
+    int       mtg  = limits.movestogo ? std::min(limits.movestogo, 50) : 50;
+
+    TimePoint timeLeft =
+      std::max(TimePoint(1), time + inc * (mtg - 1) - MoveOverhead * (2 + mtg));
+
+    double optScale, maxScale;
+    if (limits.movestogo == 0)
+    {
+        optScale = std::min(0.0120 + std::pow(ply + 3.0, 0.45) * 0.0039,
+                            0.2 * time / double(timeLeft));
+        maxScale = std::min(7.0, 4.0 + ply / 12.0);
+    }
+    else
+    {
+        optScale = std::min((0.88 + ply / 116.4) / mtg, 0.88 * time / double(timeLeft));
+        maxScale = std::min(6.3, 1.5 + 0.11 * mtg);
+    }
+
+    optimumTime = std::max(TimePoint(1), TimePoint(optScale * timeLeft));
+    maximumTime = TimePoint(std::min(0.84 * time - MoveOverhead, maxScale * optimumTime));
+    maximumTime = std::max(optimumTime, maximumTime);
+}
+
+// An unstable best move or a falling score buys more time, a move that took
+// almost all of the effort is played early.
+TimePoint
+TimeManagement::soft_limit(double bestMoveChanges, Value scoreDrop, double bestMoveEffort) const {
+    double instability = 1.0 + 1.5 * bestMoveChanges;
+    double fallingEval = std::clamp(1.0 + scoreDrop / 256.0, 0.75, 1.5);
+    double easyMove    = bestMoveEffort >= 0.9 ? 0.6 : 1.0;
+
+    return std::min(maximumTime, TimePoint(optimumTime * instability * fallingEval * easyMove));
+}
+
+}
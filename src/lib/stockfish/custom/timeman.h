@@ -0,0 +1,43 @@
+#pragma once
+
+#include "../misc.h"
+#include "../types.h"
+
+namespace Stockfish {
+
+// What "go" asked for. Times are in milliseconds, zero means not given.
+struct LimitsType {
+    TimePoint time[COLOR_NB] = {};
+    TimePoint inc[COLOR_NB]  = {};
+    TimePoint movetime       = 0;
+    int       movestogo      = 0;
+    int       depth          = 0;
+
+    bool use_time_management() const { return time[WHITE] || time[BLACK]; }
+};
+
+// Turns the clock into an optimum (soft) and a maximum (hard) time for one
+// move. The search stops at the hard limit no matter what. The soft limit is
+// checked between iterations and stretched or shrunk by how settled the
+// search looks, see soft_limit().
+class TimeManagement {
+   public:
+    // Reserve for GUI and process lag, taken off the clock for every move to go
+    static constexpr TimePoint MoveOverhead = 10;
+
+    void init(const LimitsType& limits, Color us, int ply);
+
+    TimePoint optimum() const { return optimumTime; }
+    TimePoint maximum() const { return maximumTime; }
+
+    // bestMoveChanges is the decayed count of best move changes at the root,
+    // scoreDrop how much the score fell since the previous iteration and
+    // bestMoveEffort the share of root nodes spent below the best move.
+    TimePoint soft_limit(double bestMoveChanges, Value scoreDrop, double bestMoveEffort) const;
+
+   private:
+    TimePoint optimumTime = 0;
+    TimePoint maximumTime = 0;
+};
+
+}
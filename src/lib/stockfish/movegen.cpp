@@ -159,6 +159,22 @@ ExtMove* generate_pawn_moves(const Position& pos, ExtMove* moveList, Bitboard ta
 }
 
 
+// Moves of all the pieces on from, one leaper step after the other
+template<int... Ds>
+ExtMove* make_jumps(LeaperSteps<Ds...>, ExtMove* moveList, Bitboard from, Bitboard target) {
+
+    auto step = [&]<int D>() {
+        for (Bitboard b = jump<D>(from) & target; b;)
+        {
+            Square to   = pop_lsb(b);
+            *moveList++ = Move(to - Direction(D), to);
+        }
+    };
+    (step.template operator()<Ds>(), ...);
+    return moveList;
+}
+
+
 template<Color Us, PieceType Pt, bool Checks>
 ExtMove* generate_moves(const Position& pos, ExtMove* moveList, Bitboard target) {
 
@@ -166,13 +182,26 @@ ExtMove* generate_moves(const Position& pos, ExtMove* moveList, Bitboard target)
 
     Bitboard bb = pos.pieces(Us, Pt);
 
+    if constexpr (Pt != ROOK)
+    {
+        if (!Checks)
+            return make_jumps(Leaper<Pt>(), moveList, bb, target);
+
+        // To check, you either move freely a blocker or make a direct check.
+        // Only the rook slides, so a ferz can be a blocker too.
+        Bitboard blockers = bb & pos.blockers_for_king(~Us);
+        moveList          = make_jumps(Leaper<Pt>(), moveList, bb & ~blockers,
+                                       target & pos.check_squares(Pt));
+        return make_jumps(Leaper<Pt>(), moveList, blockers, target);
+    }
+
     while (bb)
     {
         Square   from = pop_lsb(bb);
         Bitboard b    = attacks_bb<Pt>(from, pos.pieces()) & target;
 
-        // To check, you either move freely a blocker or make a direct check.
-        if (Checks && (Pt == QUEEN || !(pos.blockers_for_king(~Us) & from)))
+        // To check, you either move freely a blocker or make a direct check
+        if (Checks && !(pos.blockers_for_king(~Us) & from))
             b &= pos.check_squares(Pt);
 
         while (b)
@@ -210,8 +239,9 @@ ExtMove* generate_all(const Position& pos, ExtMove* moveList) {
     if (!Checks || pos.blockers_for_king(~Us) & ksq)
     {
         Bitboard b = attacks_bb<KING>(ksq) & (Type == EVASIONS ? ~pos.pieces(Us) : target);
+        // A king staying on the rook line of the enemy king discovers nothing
         if (Checks)
-            b &= ~attacks_bb<QUEEN>(pos.square<KING>(~Us));
+            b &= ~attacks_bb<ROOK>(pos.square<KING>(~Us));
 
         while (b)
             *moveList++ = Move(ksq, pop_lsb(b));
@@ -238,21 +268,15 @@ ExtMove* generate_all(const Position& pos, ExtMove* moveList) {
 // Returns a pointer to the end of the move list.
 template<GenType Type>
 ExtMove* generate(const Position& pos, ExtMove* moveList) {
-    if (pos.gameEndDetector.Analyse(pos) != GameEndDetector::None)
-    {
-        pos.st->movesize = 0;
+    if (pos.st->bareKing != GameEndDetector::None)
         return moveList;
-    }
-    auto start = moveList;
     static_assert(Type != LEGAL, "Unsupported type in generate()");
     assert((Type == EVASIONS) == bool(pos.checkers()));
 
     Color us = pos.side_to_move();
 
-    auto ret         = us == WHITE ? generate_all<WHITE, Type>(pos, moveList)
-                                   : generate_all<BLACK, Type>(pos, moveList);
-    pos.st->movesize = ret - start;
-    return ret;
+    return us == WHITE ? generate_all<WHITE, Type>(pos, moveList)
+                       : generate_all<BLACK, Type>(pos, moveList);
 }
 
 // Explicit template instantiations
@@ -267,12 +291,8 @@ template ExtMove* generate<NON_EVASIONS>(const Position&, ExtMove*);
 
 template<>
 ExtMove* generate<LEGAL>(const Position& pos, ExtMove* moveList) {
-
-    if (pos.gameEndDetector.Analyse(pos) != GameEndDetector::None)
-    {
-        pos.st->movesize = 0;
+    if (pos.st->bareKing != GameEndDetector::None)
         return moveList;
-    }
     Color    us     = pos.side_to_move();
     Bitboard pinned = pos.blockers_for_king(us) & pos.pieces(us);
     Square   ksq    = pos.square<KING>(us);
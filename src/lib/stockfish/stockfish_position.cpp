@@ -3,6 +3,7 @@
 #include "stockfish_helper.h"
 #include "misc.h"
 #include "types.h"
+#include "custom/pesto_evaluate.h"
 
 #include <cstring>
 #include <ios>
@@ -15,15 +16,6 @@
 using std::string;
 namespace Stockfish {
 
-namespace Zobrist {
-
-Key psq[PIECE_NB][SQUARE_NB];
-//Key enpassant[FILE_NB];
-//Key castling[CASTLING_RIGHT_NB];
-Key side, noPawns;
-}
-
-
 namespace {
 
 constexpr std::string_view PieceToCharNormal(" PNBRQK  pnbrqk");
@@ -31,59 +23,97 @@ constexpr std::string_view PieceToCharShatranj(" PHFRVS  phfrvs");
 
 constexpr Piece Pieces[] = {W_PAWN, W_KNIGHT, W_BISHOP, W_ROOK, W_QUEEN, W_KING,
                             B_PAWN, B_KNIGHT, B_BISHOP, B_ROOK, B_QUEEN, B_KING};
-}  // namespace
 
-// First and second hash functions for indexing the cuckoo tables
-inline int H1(Key h) { return h & 0x1fff; }
-inline int H2(Key h) { return (h >> 16) & 0x1fff; }
+// The hash keys, drawn at compile time in the order a startup init() used to
+// draw them, so the keys did not change
+struct ZobristKeys {
+    Key psq[PIECE_NB][SQUARE_NB];
+    //Key enpassant[FILE_NB];
+    //Key castling[CASTLING_RIGHT_NB];
+    Key side, noPawns;
+};
 
-// Cuckoo tables with Zobrist hashes of valid reversible moves, and the moves themselves
-std::array<Key, 8192>  cuckoo;
-std::array<Move, 8192> cuckooMove;
+constexpr ZobristKeys make_keys() {
+
+    ZobristKeys z{};
+    PRNG        rng(1070372);
+
+    for (Piece pc : Pieces)
+        for (int s = SQ_A1; s <= SQ_H8; ++s)
+            z.psq[pc][s] = rng.rand<Key>();
 
-// Initializes at startup the various arrays used to compute hash keys
-void Position::init() {
+    z.side    = rng.rand<Key>();
+    z.noPawns = rng.rand<Key>();
+    return z;
+}
+
+constexpr ZobristKeys Keys = make_keys();
+
+}  // namespace
 
-    PRNG rng(1070372);
+namespace Zobrist {
 
+constexpr auto& psq     = Keys.psq;
+constexpr Key   side    = Keys.side;
+constexpr Key   noPawns = Keys.noPawns;
+}
+
+Key zobrist_fingerprint() {
+    Key k = Zobrist::side ^ Zobrist::noPawns;
     for (Piece pc : Pieces)
         for (Square s = SQ_A1; s <= SQ_H8; ++s)
-            Zobrist::psq[pc][s] = rng.rand<Key>();
+            k = (k ^ Zobrist::psq[pc][s]) * 0x9E3779B97F4A7C15ULL;
+    return k;
+}
 
-    /* for (File f = FILE_A; f <= FILE_H; ++f)
-        Zobrist::enpassant[f] = rng.rand<Key>();
+// First and second hash functions for indexing the cuckoo tables
+constexpr int H1(Key h) { return h & 0x1fff; }
+constexpr int H2(Key h) { return (h >> 16) & 0x1fff; }
 
-    for (int cr = NO_CASTLING; cr <= ANY_CASTLING; ++cr)
-        Zobrist::castling[cr] = rng.rand<Key>(); */
+namespace {
 
-    Zobrist::side    = rng.rand<Key>();
-    Zobrist::noPawns = rng.rand<Key>();
+// Cuckoo tables with Zobrist hashes of valid reversible moves, and the moves themselves
+struct Cuckoo {
+    std::array<Key, 8192>  keys{};
+    std::array<Move, 8192> moves{};
+};
 
-    // Prepare the cuckoo tables
-    cuckoo.fill(0);
-    cuckooMove.fill(Move::none());
+constexpr Cuckoo make_cuckoo() {
+
+    Cuckoo c;
+    c.moves.fill(Move::none());
     [[maybe_unused]] int count = 0;
     for (Piece pc : Pieces)
-        for (Square s1 = SQ_A1; s1 <= SQ_H8; ++s1)
-            for (Square s2 = Square(s1 + 1); s2 <= SQ_H8; ++s2)
-                if ((type_of(pc) != PAWN) && (attacks_bb(type_of(pc), s1, 0) & s2))
+        for (int i = SQ_A1; i <= SQ_H8; ++i)
+            for (int j = i + 1; j <= SQ_H8; ++j)
+            {
+                Square s1 = Square(i), s2 = Square(j);
+                if ((type_of(pc) != PAWN) && (PseudoAttacks[type_of(pc)][s1] & square_bb(s2)))
                 {
                     Move move = Move(s1, s2);
                     Key  key  = Zobrist::psq[pc][s1] ^ Zobrist::psq[pc][s2] ^ Zobrist::side;
-                    int  i    = H1(key);
+                    int  k    = H1(key);
                     while (true)
                     {
-                        std::swap(cuckoo[i], key);
-                        std::swap(cuckooMove[i], move);
+                        std::swap(c.keys[k], key);
+                        std::swap(c.moves[k], move);
                         if (move == Move::none())  // Arrived at empty slot?
                             break;
-                        i = (i == H1(key)) ? H2(key) : H1(key);  // Push victim to alternative slot
+                        k = (k == H1(key)) ? H2(key) : H1(key);  // Push victim to alternative slot
                     }
                     count++;
                 }
-    //assert(count == 3668);
+            }
+    return c;
 }
 
+constexpr Cuckoo CuckooTables = make_cuckoo();
+
+}  // namespace
+
+constexpr const std::array<Key, 8192>&  cuckoo     = CuckooTables.keys;
+constexpr const std::array<Move, 8192>& cuckooMove = CuckooTables.moves;
+
 std::string square(Square s) { return std::string{char('a' + file_of(s)), char('1' + rank_of(s))}; }
 
 // Returns an ASCII representation of the position
@@ -129,9 +159,12 @@ std::ostream& operator<<(std::ostream& os, const Position& pos) {
 // The function is only used when a new position is set up
 void Position::set_state() const {
 
+    st->attacksBuilt[WHITE] = st->attacksBuilt[BLACK] = 0;
+    st->kingMovesTested     = 0;
     st->key = st->materialKey  = 0;
     st->pawnKey                = Zobrist::noPawns;
     st->nonPawnMaterial[WHITE] = st->nonPawnMaterial[BLACK] = VALUE_ZERO;
+    st->mgPsq = st->egPsq = st->gamePhase = 0;
     st->checkersBB = attackers_to(square<KING>(sideToMove)) & pieces(~sideToMove);
 
     set_check_info();
@@ -141,6 +174,9 @@ void Position::set_state() const {
         Square s  = pop_lsb(b);
         Piece  pc = piece_on(s);
         st->key ^= Zobrist::psq[pc][s];
+        st->mgPsq += mg_psq(pc, s);
+        st->egPsq += eg_psq(pc, s);
+        st->gamePhase += gamephaseInc[pc];
 
         if (type_of(pc) == PAWN)
             st->pawnKey ^= Zobrist::psq[pc][s];
@@ -160,6 +196,9 @@ void Position::set_state() const {
     for (Piece pc : Pieces)
         for (int cnt = 0; cnt < pieceCount[pc]; ++cnt)
             st->materialKey ^= Zobrist::psq[pc][cnt];
+
+    st->bareKing      = GameEndDetector::BareKing(*this);
+    st->hasLegalMoves = -1;
 }
 
 // Makes a move, and saves all information necessary
@@ -178,8 +217,9 @@ void Position::do_move(Move m, StateInfo& newSt, bool givesCheck) {
     std::memcpy(&newSt, st, offsetof(StateInfo, key));
     newSt.previous = st;
     st             = &newSt;
-    st->movesize   = -1;
     st->playMove   = Move::none();
+    st->attacksBuilt[WHITE] = st->attacksBuilt[BLACK] = 0;
+    st->kingMovesTested     = 0;
 
     // Increment ply counters. In particular, rule50 will be reset to zero later on
     // in case of a capture or a pawn move.
@@ -258,6 +298,10 @@ void Position::do_move(Move m, StateInfo& newSt, bool givesCheck) {
         // Update board and piece lists
         remove_piece(capsq);
 
+        st->mgPsq -= mg_psq(captured, capsq);
+        st->egPsq -= eg_psq(captured, capsq);
+        st->gamePhase -= gamephaseInc[captured];
+
         k ^= Zobrist::psq[captured][capsq];
         st->materialKey ^= Zobrist::psq[captured][pieceCount[captured]];
 
@@ -293,6 +337,9 @@ void Position::do_move(Move m, StateInfo& newSt, bool givesCheck) {
     move_piece(from, to);
     /*}*/
 
+    st->mgPsq += mg_psq(pc, to) - mg_psq(pc, from);
+    st->egPsq += eg_psq(pc, to) - eg_psq(pc, from);
+
     // If the moving piece is a pawn do some special extra work
     if (type_of(pc) == PAWN)
     {
@@ -330,6 +377,9 @@ void Position::do_move(Move m, StateInfo& newSt, bool givesCheck) {
 
             // Update material
             st->nonPawnMaterial[us] += PieceValue[promotion];
+            st->mgPsq += mg_psq(promotion, to) - mg_psq(pc, to);
+            st->egPsq += eg_psq(promotion, to) - eg_psq(pc, to);
+            st->gamePhase += gamephaseInc[promotion] - gamephaseInc[pc];
         }
 
         // Update pawn hash key
@@ -353,6 +403,9 @@ void Position::do_move(Move m, StateInfo& newSt, bool givesCheck) {
     // Update king attacks used for fast check detection
     set_check_info();
 
+    st->bareKing      = GameEndDetector::BareKing(*this);
+    st->hasLegalMoves = -1;
+
     // Calculate the repetition info. It is the ply distance from the previous
     // occurrence of the same position, negative in the 3-fold case, or zero
     // if the position was not repeated.
@@ -557,6 +610,42 @@ Bitboard Position::attackers_to(Square s, Bitboard occupied) const {
          | (attacks_bb<KING>(s) & pieces(KING));
 }
 
+// Fills one entry of the attack map behind attacks_by(), ALL_PIECES fills the
+// missing piece types first
+void Position::build_attacks(Color c, PieceType pt) const {
+    Bitboard* attacked = st->attackedBy[c];
+    if (pt == ALL_PIECES)
+    {
+        attacked[ALL_PIECES] = 0;
+        for (PieceType t = PAWN; t <= KING; ++t)
+        {
+            if (!(st->attacksBuilt[c] & (1 << t)))
+                build_attacks(c, t);
+            attacked[ALL_PIECES] |= attacked[t];
+        }
+    }
+    else if (pt == PAWN)
+    {
+        attacked[PAWN] = c == WHITE ? pawn_attacks_bb<WHITE>(pieces(WHITE, PAWN))
+                                    : pawn_attacks_bb<BLACK>(pieces(BLACK, PAWN));
+    }
+    else if (pt == ROOK)
+    {
+        attacked[ROOK] = 0;
+        for (Bitboard b = pieces(c, ROOK); b;)
+            attacked[ROOK] |= attacks_bb<ROOK>(pop_lsb(b), pieces());
+    }
+    else
+    {
+        attacked[pt] = leaper_attacks_bb(pt, pieces(c, pt));
+    }
+    st->attacksBuilt[c] |= 1 << pt;
+#ifdef ATTACK_STATS
+    if (pt != ALL_PIECES)
+        ++attackBuilds;
+#endif
+}
+
 // Calculates st->blockersForKing[c] and st->pinners[~c],
 // which store respectively the pieces preventing king of color c from being in check
 // and the slider pieces of color ~c pinning pieces of color c to the king.
@@ -729,9 +818,21 @@ bool Position::legal(Move m) const {
     }*/
 
     // If the moving piece is a king, check whether the destination square is
-    // attacked by the opponent.
+    // attacked by the opponent. A complete attack map is cheaper than looking
+    // for attackers, but it stops rook attacks at our king, so a checking rook
+    // is also looked at through it. A single king move does not pay for
+    // building the map, the second one at a node builds it, and the move
+    // picker's threat masks then come from it as well.
     if (type_of(piece_on(from)) == KING)
+    {
+        if (!(st->attacksBuilt[~us] & (1 << ALL_PIECES)) && ++st->kingMovesTested > 1)
+            build_attacks(~us, ALL_PIECES);
+        if (st->attacksBuilt[~us] & (1 << ALL_PIECES))
+            return !(attacks_by<ALL_PIECES>(~us) & to)
+                && !((checkers() & pieces(ROOK))
+                     && (attacks_bb<ROOK>(to, pieces() ^ from) & pieces(~us, ROOK)));
         return !(attackers_to(to, pieces() ^ from) & pieces(~us));
+    }
 
     // A non-king move is legal if and only if it is not pinned or it
     // is moving along the ray towards or away from the king.
@@ -807,55 +908,30 @@ bool Position::see_ge(Move m, int threshold) const {
 
         res ^= 1;
 
-        // Locate and remove the next least valuable attacker, and add to
-        // the bitboard 'attackers' any X-ray attackers behind it.
-        if ((bb = stmAttackers & pieces(PAWN)))
-        {
-            if ((swap = PawnValue - swap) < res)
-                break;
-            occupied ^= least_significant_square_bb(bb);
-
-            attackers |= attacks_bb<BISHOP>(to, occupied) & pieces(BISHOP, QUEEN);
-        }
-
-        else if ((bb = stmAttackers & pieces(KNIGHT)))
-        {
-            if ((swap = KnightValue - swap) < res)
-                break;
-            occupied ^= least_significant_square_bb(bb);
-        }
-
-        else if ((bb = stmAttackers & pieces(BISHOP)))
-        {
-            if ((swap = BishopValue - swap) < res)
+        // Locate the next least valuable attacker. Ferz and alfil are cheaper
+        // than the horse here, so the order differs from chess.
+        PieceType pt = KING;
+        for (PieceType t : {PAWN, QUEEN, BISHOP, KNIGHT, ROOK})
+            if ((bb = stmAttackers & pieces(t)))
+            {
+                pt = t;
                 break;
-            occupied ^= least_significant_square_bb(bb);
+            }
 
-            attackers |= attacks_bb<BISHOP>(to, occupied) & pieces(BISHOP);
-        }
+        // If we "capture" with the king but the opponent still has attackers,
+        // reverse the result.
+        if (pt == KING)
+            return (attackers & ~pieces(stm)) ? res ^ 1 : res;
 
-        else if ((bb = stmAttackers & pieces(ROOK)))
-        {
-            if ((swap = RookValue - swap) < res)
-                break;
-            occupied ^= least_significant_square_bb(bb);
+        if ((swap = PieceValue[pt] - swap) < res)
+            break;
 
+        // Remove the attacker. The rook is the only slider, so the only X-ray
+        // attacker that can appear is a rook behind a piece on the same line.
+        bb = least_significant_square_bb(bb);
+        occupied ^= bb;
+        if (attacks_bb<ROOK>(to) & bb)
             attackers |= attacks_bb<ROOK>(to, occupied) & pieces(ROOK);
-        }
-
-        else if ((bb = stmAttackers & pieces(QUEEN)))
-        {
-            if ((swap = QueenValue - swap) < res)
-                break;
-            occupied ^= least_significant_square_bb(bb);
-
-            attackers |= (attacks_bb<QUEEN>(to, occupied) & pieces(QUEEN));
-        }
-
-        else  // KING
-              // If we "capture" with the king but the opponent still has attackers,
-              // reverse the result.
-            return (attackers & ~pieces(stm)) ? res ^ 1 : res;
     }
 
     return bool(res);
@@ -896,10 +972,11 @@ bool Position::pseudo_legal(const Move m) const {
         if ((Rank8BB | Rank1BB) & to)
             return false;
 
+        // There is no double push in shatranj, the generator does not produce one either
         if (!(pawn_attacks_bb(us, from) & pieces(~us) & to)  // Not a capture
             && !((from + pawn_push(us) == to) && empty(to))  // Not a single push
-            && !((from + 2 * pawn_push(us) == to)            // Not a double push
-                 && (relative_rank(us, from) == RANK_2) && empty(to) && empty(to - pawn_push(us))))
+            /* && !((from + 2 * pawn_push(us) == to)            // Not a double push
+                 && (relative_rank(us, from) == RANK_2) && empty(to) && empty(to - pawn_push(us))) */)
             return false;
     }
     else if (!(attacks_bb(type_of(pc), from, pieces()) & to))
@@ -1107,6 +1184,51 @@ void Position::set_check_info() const {
 }
 
 
+GameEndDetector::GameEnd Position::game_end() const {
+    if (st->bareKing == GameEndDetector::None)
+        has_legal_moves();
+    return known_game_end();
+}
+
+// Out of check there are no special moves in shatranj, every pseudo-legal
+// move of a piece that is not pinned is legal, and so is a king step to a
+// square the opponent does not attack. Only when no such move exists, in a
+// stalemate or with just pinned pieces left to move, are the moves generated.
+bool Position::has_legal_moves() const {
+    if (st->hasLegalMoves >= 0)
+        return st->hasLegalMoves;
+
+    // Move generation has nothing to offer once the game is over by bare king
+    if (!checkers() && st->bareKing == GameEndDetector::None)
+    {
+        Color    us      = sideToMove;
+        Bitboard targets = ~pieces(us);
+        Bitboard movers  = pieces(us) & ~blockers_for_king(us);
+        Bitboard pawns   = movers & pieces(PAWN);
+
+        Bitboard reach = (us == WHITE ? shift<NORTH>(pawns) : shift<SOUTH>(pawns)) & ~pieces();
+        reach |= (us == WHITE ? pawn_attacks_bb<WHITE>(pawns) : pawn_attacks_bb<BLACK>(pawns))
+               & pieces(~us);
+        for (PieceType pt : {KNIGHT, BISHOP, QUEEN})
+            reach |= leaper_attacks_bb(pt, movers & pieces(pt)) & targets;
+        for (Bitboard b = movers & pieces(ROOK); b && !reach;)
+            reach |= attacks_bb<ROOK>(pop_lsb(b), pieces()) & targets;
+        for (Bitboard b = attacks_bb<KING>(square<KING>(us)) & targets; b && !reach;)
+        {
+            Square s = pop_lsb(b);
+            if (!(attackers_to(s) & pieces(~us)))
+                reach |= s;
+        }
+        if (reach)
+        {
+            st->hasLegalMoves = true;
+            return true;
+        }
+    }
+    st->hasLegalMoves = MoveList<LEGAL>(*this).size() != 0;
+    return st->hasLegalMoves;
+}
+
 // Used to do a "null move": it flips
 // the side to move without executing any move on the board.
 void Position::do_null_move(StateInfo& newSt, TranspositionTable& tt) {
@@ -1114,6 +1236,7 @@ void Position::do_null_move(StateInfo& newSt, TranspositionTable& tt) {
     assert(!checkers());
     assert(&newSt != st);
 
+    // The attack maps are copied too, the pieces stay where they are
     std::memcpy(&newSt, st, sizeof(StateInfo));
 
     newSt.previous = st;
@@ -1140,7 +1263,10 @@ void Position::do_null_move(StateInfo& newSt, TranspositionTable& tt) {
 
     set_check_info();
 
-    st->repetition = 0;
+    st->bareKing        = GameEndDetector::BareKing(*this);
+    st->hasLegalMoves   = -1;
+    st->kingMovesTested = 0;
+    st->repetition      = 0;
 
     assert(pos_is_ok());
 }
@@ -24,6 +24,9 @@ struct StateInfo {
     int   castlingRights;
     int   rule50;
     int   pliesFromNull;
+    int   mgPsq;  // PeSTO sums, white minus black
+    int   egPsq;
+    int   gamePhase;
     // Square epSquare;
 
     // Not copied when making a move (will be recomputed anyhow)
@@ -33,14 +36,23 @@ struct StateInfo {
     Bitboard   blockersForKing[COLOR_NB];
     Bitboard   pinners[COLOR_NB];
     Bitboard   checkSquares[PIECE_TYPE_NB];
+    // Squares attacked by each color, by piece type and ALL_PIECES for all of
+    // them. Built on first use, bit pt of attacksBuilt[c] says it is there
+    Bitboard   attackedBy[COLOR_NB][PIECE_TYPE_NB];
+    uint8_t    attacksBuilt[COLOR_NB];
+    // King moves legal() has looked at, the second one builds the map
+    uint8_t    kingMovesTested;
     Piece      capturedPiece;
     int        repetition;
+    // Game end by the bare king rule, and whether the side to move has a legal
+    // move (-1 until it is known), see Position::game_end()
+    GameEndDetector::GameEnd bareKing;
+    int8_t                   hasLegalMoves;
 
     // Used by NNUE
     //Eval::NNUE::Accumulator<Eval::NNUE::TransformedFeatureDimensionsBig>   accumulatorBig;
     //Eval::NNUE::Accumulator<Eval::NNUE::TransformedFeatureDimensionsSmall> accumulatorSmall;
     DirtyPiece dirtyPiece;
-    int        movesize;
     Move       playMove;
 };
 
@@ -57,7 +69,6 @@ using StateListPtr = std::unique_ptr<std::deque<StateInfo>>;
 // traversing the search tree.
 class Position {
    public:
-    static void init();
     // FEN string input/output
     Position&
     set(const std::string& fenStr, /*bool isChess960,*/ StateInfo* si, bool shatranj = false);
@@ -83,8 +94,14 @@ class Position {
     Bitboard attackers_to(Square s) const;
     Bitboard attackers_to(Square s, Bitboard occupied) const;
     void     update_slider_blockers(Color c) const;
+    // Cached per position, ALL_PIECES for the squares attacked by any piece
     template<PieceType Pt>
     Bitboard attacks_by(Color c) const;
+#ifdef ATTACK_STATS
+    // attacks_by() calls, and the piece types whose attacks were built for them
+    uint64_t attack_queries() const { return attackQueries; }
+    uint64_t attack_builds() const { return attackBuilds; }
+#endif
 
     // Position representation
     Bitboard pieces(PieceType pt = ALL_PIECES) const;
@@ -117,6 +134,18 @@ class Position {
     bool  has_game_cycle(int ply) const;
     Color side_to_move() const;
 
+    // The exact result, generates the legal moves once if they are not known
+    GameEndDetector::GameEnd game_end() const;
+    // Whether the side to move has a legal move, kept like game_end() keeps it.
+    // Mostly answered from bitboards without generating a move
+    bool has_legal_moves() const;
+    // Records the number of legal moves a caller has generated itself, so that
+    // game_end() does not generate them again. Move generation never does this.
+    void set_legal_moves(size_t count);
+    // What is known without move generation: the bare king rule and a side to
+    // move already found without legal moves
+    GameEndDetector::GameEnd known_game_end() const;
+
     Bitboard blockers_for_king(Color c) const;
 
     Key key() const;
@@ -142,42 +171,16 @@ class Position {
     int        gamePly;
     Color      sideToMove;
     GameEndDetector gameEndDetector;
-
-    void                                         dump() const;
-    std::tuple<bool, PieceType, bool, PieceType> IsMoveToAProtectedPosition(Move& m);
-    PieceType                                    GetLeastValuablePieceTypeFromBitboard(Bitboard bb);
-    std::tuple<bool, PieceType>                  IsSquareUnderAttackByColor(Square s, Color c);
+#ifdef ATTACK_STATS
+    mutable uint64_t attackQueries = 0;
+    mutable uint64_t attackBuilds  = 0;
+#endif
+
+    void                        build_attacks(Color c, PieceType pt) const;
+    void                        dump() const;
+    std::tuple<bool, PieceType> IsSquareUnderAttackByColor(Square s, Color c);
 };
 
-inline PieceType Position::GetLeastValuablePieceTypeFromBitboard(Bitboard bb) {
-    PieceType ret = NO_PIECE_TYPE;
-    while (bb != 0)
-    {
-        Square    lsbsq = lsb(bb);
-        PieceType cur   = type_of(piece_on(lsbsq));
-        if (PieceValue[cur] < PieceValue[ret])
-        {
-            ret = cur;
-        }
-        bb ^= lsbsq;
-    }
-    return ret;
-}
-
-inline std::tuple<bool, PieceType, bool, PieceType> Position::IsMoveToAProtectedPosition(Move& m) {
-    Piece pc = moved_piece(m);
-
-    remove_piece(m.from_sq());
-    auto attacker_bb        = attackers_to(m.to_sq(), pieces());
-    auto bba_protected      = attacker_bb & pieces(side_to_move());
-    auto bba_attacked_by_op = attacker_bb & pieces(~side_to_move());
-    put_piece(pc, m.from_sq());
-
-    return std::make_tuple(bba_protected != 0, GetLeastValuablePieceTypeFromBitboard(bba_protected),
-                           bba_attacked_by_op != 0,
-                           GetLeastValuablePieceTypeFromBitboard(bba_attacked_by_op));
-}
-
 inline std::tuple<bool, PieceType> Position::IsSquareUnderAttackByColor(Square s, Color c) {
     auto bba      = attackers_to(s, pieces()) & pieces(c);
     auto attacker = bba & s;
@@ -201,6 +204,14 @@ inline std::tuple<ExtMove*, size_t> all_possible_counter_moves(Position pos, Mov
     return std::make_tuple(retlist.begin(), retlist.size());
 }
 
+inline void Position::set_legal_moves(size_t count) { st->hasLegalMoves = count != 0; }
+
+inline GameEndDetector::GameEnd Position::known_game_end() const {
+    if (st->bareKing != GameEndDetector::None || st->hasLegalMoves != 0)
+        return st->bareKing;
+    return sideToMove == WHITE ? GameEndDetector::BlackWin : GameEndDetector::WhiteWin;
+}
+
 inline bool Position::empty(Square s) const { return piece_on(s) == NO_PIECE; }
 
 inline bool Position::capture(Move m) const {
@@ -220,6 +231,10 @@ inline void Position::do_move(Move m, StateInfo& newSt) { do_move(m, newSt, give
 
 std::ostream& operator<<(std::ostream& os, const Position& pos);
 
+// A hash of all Zobrist keys. Files that keep keys or bits of keys, like TT
+// snapshots, store it to tell whether they match the keys of this build.
+Key zobrist_fingerprint();
+
 inline void Position::dump() const {
     std::cout << *this << std::endl;
     StateInfo* current = st;
@@ -323,18 +338,12 @@ inline Bitboard Position::attackers_to(Square s) const { return attackers_to(s,
 
 template<PieceType Pt>
 inline Bitboard Position::attacks_by(Color c) const {
-
-    if constexpr (Pt == PAWN)
-        return c == WHITE ? pawn_attacks_bb<WHITE>(pieces(WHITE, PAWN))
-                          : pawn_attacks_bb<BLACK>(pieces(BLACK, PAWN));
-    else
-    {
-        Bitboard threats   = 0;
-        Bitboard attackers = pieces(c, Pt);
-        while (attackers)
-            threats |= attacks_bb<Pt>(pop_lsb(attackers), pieces());
-        return threats;
-    }
+#ifdef ATTACK_STATS
+    ++attackQueries;
+#endif
+    if (!(st->attacksBuilt[c] & (1 << Pt)))
+        build_attacks(c, Pt);
+    return st->attackedBy[c][Pt];
 }
 
 inline Bitboard Position::check_squares(PieceType pt) const { return st->checkSquares[pt]; }
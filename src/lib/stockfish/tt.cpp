@@ -18,14 +18,27 @@
 
 #include "tt.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <cstdlib>
+#include <cstdio>
 #include <cstring>
+#include <fstream>
 #include <iostream>
+#include <thread>
+#include <vector>
+
+#if !defined(_WIN32)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
 
 #include "memory.h"
 #include "misc.h"
+#include "stockfish_position.h"
 //#include "syzygy/tbprobe.h"
 // #include "thread.h"
 
@@ -134,26 +147,76 @@ void TTWriter::write(
 
 
 // A TranspositionTable is an array of Cluster, of size clusterCount. Each cluster consists of ClusterSize number
-// of TTEntry. Each non-empty TTEntry contains information on exactly one position. The size of a Cluster should
-// divide the size of a cache line for best performance, as the cacheline is prefetched when possible.
+// of TTEntry. Each non-empty TTEntry contains information on exactly one position. A Cluster fills one cache line,
+// so a probe touches a single line, the one prefetched before do_move().
 
-static constexpr int ClusterSize = 3;
+static constexpr int ClusterSize = 6;
 
-struct Cluster {
+struct alignas(64) Cluster {
     TTEntry entry[ClusterSize];
-    char    padding[2];  // Pad to 32 bytes
+    char    padding[4];  // Pad to 64 bytes
+};
+
+static_assert(sizeof(Cluster) == 64, "Suboptimal Cluster size");
+
+
+// A snapshot file is this header followed by the clusters as they lie in
+// memory. The header fills a cache line, so clusters mapped straight from the
+// file stay aligned. A file is only loaded into the build that wrote it: the
+// version covers the entry layout and the index function, the key scheme the
+// Zobrist keys that key16 and the cluster index are taken from.
+struct TTFileHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t clusterBytes;
+    uint64_t clusterCount;
+    uint64_t keyScheme;
+    uint8_t  generation8;
+    char     padding[31];
 };
 
-static_assert(sizeof(Cluster) == 32, "Suboptimal Cluster size");
+static_assert(sizeof(TTFileHeader) == 64, "Header must keep the clusters aligned");
+
+static constexpr char     TTFileMagic[8] = "SHTJ-TT";
+static constexpr uint32_t TTFileVersion  = 1;
+
+static bool header_matches(const TTFileHeader& h, uint64_t fileSize) {
+    return std::memcmp(h.magic, TTFileMagic, sizeof(h.magic)) == 0 && h.version == TTFileVersion
+        && h.clusterBytes == sizeof(Cluster) && h.keyScheme == zobrist_fingerprint()
+        && h.clusterCount > 0 && fileSize == sizeof(h) + h.clusterCount * sizeof(Cluster);
+}
+
+
+// Runs f(start, end) on threadCount threads, each on its own slice of the
+// clusterCount clusters. The calling thread takes the last slice.
+template<typename F>
+static void for_each_slice(size_t threadCount, size_t clusterCount, const F& f) {
+    threadCount = std::max<size_t>(1, std::min(threadCount, clusterCount));
+
+    std::vector<std::thread> threads;
+    const size_t             stride = clusterCount / threadCount;
+    for (size_t i = 0; i + 1 < threadCount; ++i)
+        threads.emplace_back(f, stride * i, stride * (i + 1));
+
+    f(stride * (threadCount - 1), clusterCount);
+
+    for (auto& t : threads)
+        t.join();
+}
 
 
 // Sets the size of the transposition table,
 // measured in megabytes. Transposition table consists
 // of clusters and each cluster consists of ClusterSize number of TTEntry.
-void TranspositionTable::resize(size_t mbSize /* , ThreadPool& threads */) {
-    aligned_large_pages_free(table);
+// With keepEntries the entries of the old table are rehashed into the new one
+// instead of being thrown away, see rehash().
+void TranspositionTable::resize(size_t mbSize, size_t threadCount, bool keepEntries) {
+    Cluster* const oldTable        = table;
+    const size_t   oldClusterCount = clusterCount;
+    const size_t   oldMappedSize   = mappedSize;
 
     clusterCount = mbSize * 1024 * 1024 / sizeof(Cluster);
+    mappedSize   = 0;
 
     table = static_cast<Cluster*>(aligned_large_pages_alloc(clusterCount * sizeof(Cluster)));
 
@@ -163,32 +226,92 @@ void TranspositionTable::resize(size_t mbSize /* , ThreadPool& threads */) {
         exit(EXIT_FAILURE);
     }
 
-    clear(/* threads */);
+    if (keepEntries && oldTable)
+        rehash(oldTable, oldClusterCount, threadCount);
+    else
+        clear(threadCount);
+
+    release(oldTable, oldMappedSize);
 }
 
 
-// Initializes the entire transposition table to zero,
-// in a multi-threaded way.
-void TranspositionTable::clear(/* ThreadPool& threads */) {
-    generation8 = 0;
-    /* const size_t threadCount = threads.num_threads();
-
-    for (size_t i = 0; i < threadCount; ++i)
+void TranspositionTable::release(Cluster* t, size_t mapped) {
+#if !defined(_WIN32)
+    if (mapped)
     {
-        threads.run_on_thread(i, [this, i, threadCount]() {
-            // Each thread will zero its part of the hash table
-            const size_t stride = clusterCount / threadCount;
-            const size_t start  = stride * i;
-            const size_t len    = i + 1 != threadCount ? stride : clusterCount - start;
+        munmap(reinterpret_cast<char*>(t) - sizeof(TTFileHeader), mapped);
+        return;
+    }
+#endif
+    aligned_large_pages_free(t);
+}
 
 
-        });
-    } */
+// Fills the new table from the old one, every thread builds its own slice of
+// new clusters and only reads the old table.
+//
+// A cluster index is the high part of key * clusterCount, and an entry only
+// keeps the low 16 bits of its key, so the cluster a key lands on in the new
+// table is only known up to the range of new clusters that cover the old one.
+// New cluster j collects the entries of every old cluster whose key range
+// overlaps its own and keeps the most valuable ClusterSize of them by the
+// replacement rule of probe(). When the table shrinks every entry is a
+// candidate for one or two new clusters. When it grows an entry is copied to
+// each of the new clusters covering its old one: probe() finds it in the
+// right one and the copies in the others are replaced like any stale entry.
+void TranspositionTable::rehash(const Cluster* oldTable, size_t oldClusterCount, size_t threadCount) {
+    const uint8_t gen = generation8;
+
+    for_each_slice(threadCount, clusterCount, [&](size_t start, size_t end) {
+        for (size_t j = start; j < end; ++j)
+        {
+            Cluster  c{};
+            TTEntry* tte = c.entry;
+            // First and last old cluster of the keys that land on cluster j, the
+            // products fit in 64 bits for tables below 256 TB
+            const size_t first = j * oldClusterCount / clusterCount;
+            const size_t last  = ((j + 1) * oldClusterCount - 1) / clusterCount;
+
+            for (size_t i = first; i <= last; ++i)
+                for (const TTEntry& e : oldTable[i].entry)
+                {
+                    if (!e.is_occupied())
+                        continue;
+
+                    const int value = e.depth8 - e.relative_age(gen) * 2;
+                    TTEntry*  slot  = nullptr;
+                    for (int k = 0; k < ClusterSize && !slot; ++k)
+                        if (!tte[k].is_occupied() || tte[k].key16 == e.key16)
+                            slot = &tte[k];
+
+                    if (!slot)
+                    {
+                        slot = tte;
+                        for (int k = 1; k < ClusterSize; ++k)
+                            if (slot->depth8 - slot->relative_age(gen) * 2
+                                > tte[k].depth8 - tte[k].relative_age(gen) * 2)
+                                slot = &tte[k];
+                    }
+
+                    if (!slot->is_occupied() || value > slot->depth8 - slot->relative_age(gen) * 2)
+                        *slot = e;
+                }
+
+            table[j] = c;
+        }
+    });
+}
 
-    std::memset(&table[0], 0, clusterCount * sizeof(Cluster));
 
-    /* for (size_t i = 0; i < threadCount; ++i)
-        threads.wait_on_thread(i); */
+// Initializes the entire transposition table to zero,
+// in a multi-threaded way.
+void TranspositionTable::clear(size_t threadCount) {
+    generation8 = 0;
+
+    for_each_slice(threadCount, clusterCount, [this](size_t start, size_t end) {
+        // Each thread will zero its part of the hash table
+        std::memset(&table[start], 0, (end - start) * sizeof(Cluster));
+    });
 }
 
 
@@ -248,4 +371,84 @@ TTEntry* TranspositionTable::first_entry(const Key key) const {
     return &table[mul_hi64(key, clusterCount)].entry[0];
 }
 
+
+// The snapshot is written next to the file and renamed over it, so a table
+// mapped from the old file keeps its pages while the new one is written.
+bool TranspositionTable::save(const std::string& path) const {
+    TTFileHeader h{};
+    std::memcpy(h.magic, TTFileMagic, sizeof(h.magic));
+    h.version      = TTFileVersion;
+    h.clusterBytes = sizeof(Cluster);
+    h.clusterCount = clusterCount;
+    h.keyScheme    = zobrist_fingerprint();
+    h.generation8  = generation8;
+
+    const std::string tmp = path + ".tmp";
+    std::ofstream     out(tmp, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    out.write(reinterpret_cast<const char*>(table), std::streamsize(clusterCount * sizeof(Cluster)));
+    out.close();
+
+    if (!out)
+    {
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return std::rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+
+// Maps the file copy-on-write, so the table is usable at once, pages in as the
+// search touches it and the search's writes never reach the file. The table
+// takes the size and generation of the snapshot. On failure the current table
+// is kept.
+bool TranspositionTable::load(const std::string& path) {
+    TTFileHeader h{};
+
+#if !defined(_WIN32)
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat sb;
+    void*       mapping = MAP_FAILED;
+    if (fstat(fd, &sb) == 0 && pread(fd, &h, sizeof(h), 0) == ssize_t(sizeof(h))
+        && header_matches(h, uint64_t(sb.st_size)))
+        mapping = mmap(nullptr, size_t(sb.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (mapping == MAP_FAILED)
+        return false;
+
+    release(table, mappedSize);
+    table      = reinterpret_cast<Cluster*>(static_cast<char*>(mapping) + sizeof(h));
+    mappedSize = size_t(sb.st_size);
+#else
+    // No mmap here, the snapshot is read into a table of its size
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in)
+        return false;
+
+    const uint64_t fileSize = uint64_t(in.tellg());
+    in.seekg(0);
+    if (!in.read(reinterpret_cast<char*>(&h), sizeof(h)) || !header_matches(h, fileSize))
+        return false;
+
+    auto* t = static_cast<Cluster*>(aligned_large_pages_alloc(h.clusterCount * sizeof(Cluster)));
+    if (!t || !in.read(reinterpret_cast<char*>(t), std::streamsize(h.clusterCount * sizeof(Cluster))))
+    {
+        aligned_large_pages_free(t);
+        return false;
+    }
+
+    release(table, mappedSize);
+    table      = t;
+    mappedSize = 0;
+#endif
+
+    clusterCount = h.clusterCount;
+    generation8  = h.generation8;
+    return true;
+}
+
 }  // namespace Stockfish
@@ -21,6 +21,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <string>
 #include <tuple>
 
 #include "memory.h"
@@ -69,10 +70,12 @@ struct TTWriter {
 class TranspositionTable {
 
    public:
-    ~TranspositionTable() { aligned_large_pages_free(table); }
+    ~TranspositionTable() { release(table, mappedSize); }
 
-    void resize(size_t mbSize /* , ThreadPool& threads */);  // Set TT size
-    void clear(/* ThreadPool& threads */);                   // Re-initialize memory, multithreaded
+    void resize(size_t mbSize,
+                size_t threadCount = 1,
+                bool   keepEntries = false);  // Set TT size, optionally rehashing the old entries
+    void clear(size_t threadCount = 1);       // Re-initialize memory, multithreaded
     int  hashfull()
       const;  // Approximate what fraction of entries (permille) have been written to during this root search
 
@@ -84,11 +87,18 @@ class TranspositionTable {
     TTEntry* first_entry(const Key key)
       const;  // This is the hash function; its only external use is memory prefetching.
 
+    bool save(const std::string& path) const;  // Write a snapshot, false if the file can't be written
+    bool load(const std::string& path);  // Map a snapshot in place of the table, false if it doesn't fit
+
    private:
     friend struct TTEntry;
 
+    void        rehash(const Cluster* oldTable, size_t oldClusterCount, size_t threadCount);
+    static void release(Cluster* t, size_t mapped);
+
     size_t   clusterCount;
-    Cluster* table = nullptr;
+    Cluster* table      = nullptr;
+    size_t   mappedSize = 0;  // Size of the file mapping the table lives in, 0 if allocated
 
     uint8_t generation8 = 0;  // Size must be not bigger than TTEntry::genBound8
 };
@@ -35,6 +35,16 @@
 //
 // -DUSE_PEXT    | Add runtime support for use of pext asm-instruction. Works
 //               | only in 64-bit mode and requires hardware with pext support.
+//               | Without it x86-64 GCC/Clang builds still index the rook
+//               | attacks with pext when the CPU has a fast one, picked at
+//               | startup (USE_PEXT_DISPATCH).
+//
+// -DUSE_AVX2    | Compute the leaper attacks of a whole bitboard with AVX2
+//               | variable shifts. Needs -mavx2.
+//
+// -DATTACK_STATS | Count the attacks_by() calls and attack map scans of a
+//                | Position, for `shatranj_bench picker`. Off by default, the
+//                | counting sits in the hottest path of the search.
 
 #include <cassert>
 #include <cstdint>
@@ -83,6 +93,10 @@
     #define pext(b, m) 0
 #endif
 
+#if !defined(USE_PEXT) && defined(__GNUC__) && defined(__x86_64__)
+    #define USE_PEXT_DISPATCH
+#endif
+
 namespace Stockfish {
 
 #ifdef USE_POPCNT
@@ -159,7 +173,6 @@ constexpr Value VALUE_TB_LOSS_IN_MAX_PLY = -VALUE_TB_WIN_IN_MAX_PLY;
 // In the code, we make the assumption that these values
 // are such that non_pawn_material() can be used to uniquely
 // identify the material on the board.
-constexpr Value MobilityW   = 1;
 constexpr Value PawnValue   = 208;
 constexpr Value KnightValue = 781;
 constexpr Value BishopValue = 680;  // 825;
@@ -15,6 +15,7 @@
 #include "stockfish_helper.h"
 #include "stockfish_position.h"
 #include "movegen.h"
+#include "evaluate.h"
 #include "../custom/helper.h"
 namespace {
 
@@ -481,6 +482,64 @@ TEST(Bitboard, CheckIfKeysAreProducedCorrectly) {
     auto afterKey = pos.key();
     assert(initialKey == afterKey);
 }
+TEST(Bitboard, LeaperAttacksMatchTheTables) {
+    for (PieceType pt : {KNIGHT, BISHOP, QUEEN, KING})
+    {
+        for (Square s = SQ_A1; s <= SQ_H8; ++s)
+            EXPECT_EQ(leaper_attacks_bb(pt, square_bb(s)), attacks_bb(pt, s, 0)) << s;
+
+        // A set of pieces attacks the union of their squares' attacks
+        Bitboard pieces = 0x8100'0024'1800'0081ULL, expected = 0;
+        for (Bitboard b = pieces; b;)
+            expected |= attacks_bb(pt, pop_lsb(b), 0);
+        EXPECT_EQ(leaper_attacks_bb(pt, pieces), expected);
+    }
+}
+
+TEST(Bitboard, AttackMapIsBuiltOncePerPosition) {
+    StateInfo st;
+    Position  pos;
+    // Black rook gives check along the e file
+    pos.set("4r3/8/8/8/8/2N5/4K3/7k w 0 1", &st, false);
+
+    auto expected = [&](Color c) {
+        Bitboard b = 0;
+        for (Square s = SQ_A1; s <= SQ_H8; ++s)
+            if (pos.attackers_to(s) & pos.pieces(c))
+                b |= s;
+        return b;
+    };
+
+#ifdef ATTACK_STATS
+    uint64_t builds = pos.attack_builds();
+#endif
+    EXPECT_EQ(pos.attacks_by<ALL_PIECES>(BLACK), expected(BLACK));
+    EXPECT_EQ(pos.attacks_by<ROOK>(BLACK), expected(BLACK) & ~attacks_bb<KING>(SQ_H1));
+    uint8_t built = pos.st->attacksBuilt[BLACK];
+    EXPECT_EQ(built, (1 << ALL_PIECES) | (1 << PAWN) | (1 << KNIGHT) | (1 << BISHOP)
+                       | (1 << ROOK) | (1 << QUEEN) | (1 << KING));
+#ifdef ATTACK_STATS
+    // Pawn, knight, ferz, rook, alfil and king attacks, once each
+    EXPECT_EQ(pos.attack_builds(), builds + 6);
+#endif
+
+    // The king can not step back along the checking rook's line
+    auto moves = MoveList<LEGAL>(pos);
+    EXPECT_TRUE(std::find(moves.begin(), moves.end(), Move(SQ_E2, SQ_E1)) == moves.end());
+    EXPECT_TRUE(std::find(moves.begin(), moves.end(), Move(SQ_E2, SQ_D2)) != moves.end());
+    EXPECT_EQ(pos.st->attacksBuilt[BLACK], built);
+#ifdef ATTACK_STATS
+    EXPECT_EQ(pos.attack_builds(), builds + 6);
+#endif
+
+    StateInfo st2;
+    pos.do_move(Move(SQ_E2, SQ_D2), st2);
+    EXPECT_EQ(pos.attacks_by<ALL_PIECES>(WHITE), expected(WHITE));
+    EXPECT_EQ(pos.attacks_by<KNIGHT>(WHITE), attacks_bb<KNIGHT>(SQ_C3));
+    pos.undo_move(Move(SQ_E2, SQ_D2));
+    EXPECT_EQ(pos.attacks_by<ALL_PIECES>(BLACK), expected(BLACK));
+}
+
 /*
     TODO checks:
     * write a test for adapted position class
@@ -494,4 +553,88 @@ TEST(Bitboard, CheckIfKeysAreProducedCorrectly) {
     * write a test for get possible moves
 */
 
+TEST(Bitboard, EvaluationAndKingMovesShareTheAttackMap) {
+    StateInfo st;
+    Position  pos;
+    // The white king on e1 has five free squares
+    pos.set("r3s3/8/2h5/8/8/2H5/8/R3S2F w 0 1", &st, true);
+    ASSERT_TRUE(mobility_enabled());
+
+    evaluate(pos, nullptr, nullptr);
+    // Mobility reads the horse, alfil, ferz and rook attacks of both sides
+    constexpr uint8_t Mobile = (1 << KNIGHT) | (1 << BISHOP) | (1 << QUEEN) | (1 << ROOK);
+    EXPECT_EQ(st.attacksBuilt[WHITE] & Mobile, Mobile);
+    EXPECT_EQ(st.attacksBuilt[BLACK] & Mobile, Mobile);
+    EXPECT_FALSE(st.attacksBuilt[BLACK] & (1 << ALL_PIECES));
+#ifdef ATTACK_STATS
+    uint64_t builds = pos.attack_builds();
+    evaluate(pos, nullptr, nullptr);
+    EXPECT_EQ(pos.attack_builds(), builds);
+#endif
+
+    // The second king move legal() looks at completes black's map, only the
+    // pawn and king attacks are left to scan
+    EXPECT_EQ(MoveList<LEGAL>(pos).size(), 24);
+    EXPECT_TRUE(st.attacksBuilt[BLACK] & (1 << ALL_PIECES));
+#ifdef ATTACK_STATS
+    EXPECT_EQ(pos.attack_builds(), builds + 2);
+#endif
+}
+
 }  // namespace
+
+TEST(Bitboard, MoveGenerationLeavesTheGameEndAlone) {
+    StateInfo st;
+    Position  pos;
+    // Black is mated, the blocked pawn keeps the bare king rule out of it
+    pos.set("k6R/7p/1K5P/8/8/8/8/8 b 0 1", &st, false);
+
+    EXPECT_EQ(MoveList<LEGAL>(pos).size(), 0);
+    EXPECT_EQ(pos.known_game_end(), GameEndDetector::None);
+    EXPECT_EQ(pos.game_end(), GameEndDetector::WhiteWin);
+    EXPECT_EQ(pos.known_game_end(), GameEndDetector::WhiteWin);
+
+    StateInfo st2;
+    pos.set("k7/7p/1K5P/8/8/8/8/7R b 0 1", &st2, false);
+    auto moves = MoveList<LEGAL>(pos);
+    pos.set_legal_moves(moves.size());
+    EXPECT_EQ(moves.size(), 1);
+    EXPECT_EQ(pos.known_game_end(), GameEndDetector::None);
+}
+
+TEST(Bitboard, HasLegalMovesAgreesWithMoveGeneration) {
+    // The horse is pinned and the rook on b1 takes the king's squares: stalemate
+    // with a piece on the board. With the rook on c1 the horse is free to move,
+    // and without the b1 rook only the king can move.
+    const std::pair<const char*, size_t> positions[] = {{"s7/h7/8/8/8/8/8/RR2S3 b 0 1", 0},
+                                                        {"s7/h7/8/8/8/8/8/1RR1S3 b 0 1", 3},
+                                                        {"s7/h7/8/8/8/8/8/R3S3 b 0 1", 2},
+                                                        {StartFENShatranj, 16}};
+    for (auto [fen, count] : positions)
+    {
+        StateInfo st;
+        Position  pos;
+        pos.set(fen, &st, true);
+        EXPECT_EQ(MoveList<LEGAL>(pos).size(), count) << fen;
+        EXPECT_EQ(pos.has_legal_moves(), count != 0) << fen;
+        EXPECT_EQ(pos.known_game_end() == GameEndDetector::None, count != 0) << fen;
+    }
+}
+
+TEST(Bitboard, RookAttacksAgreeForPextAndMagicIndices) {
+    const bool pext = UsePext;
+
+    for (bool usePext : {false, true})
+    {
+        // Without a fast enough pext there is only the magic table to check
+        if (!Bitboards::init_rook_attacks(usePext))
+            continue;
+
+        for (Square s = SQ_A1; s <= SQ_H8; ++s)
+            for (Bitboard occupied : {Bitboard(0), Bitboard(0x0000'ff00'0000'ff00),
+                                      Bitboard(0x8142'2418'1824'4281), ~square_bb(s)})
+                EXPECT_EQ(attacks_bb<ROOK>(s, occupied), sliding_attack(s, occupied))
+                  << Bitboards::rook_indexing() << " " << int(s);
+    }
+    Bitboards::init_rook_attacks(pext);
+}
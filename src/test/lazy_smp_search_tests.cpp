@@ -0,0 +1,39 @@
+#include "custom_search.h"
+#include "lazy_smp_search.h"
+#include "movegen.h"
+#include "stockfish_position.h"
+#include "tt.h"
+#include "types.h"
+#include <gtest/gtest.h>
+
+using namespace Stockfish;
+
+TEST(LazySmpSearchTests, HelpersAgreeOnSimplePuzzle) {
+    Position  pos;
+    StateInfo st;
+    pos.set("4k3/r7/8/8/4n1PK/8/8/8 b - - 0 1", &st, false);
+
+    TranspositionTable tt;
+    tt.resize(64);
+    lazy_smp_search<true> s(&tt, pos, 4);
+    EXPECT_EQ(s.thread_count(), 4);
+    EXPECT_EQ(s.iterative_deepening(4), Move(SQ_A7, SQ_H7));
+    EXPECT_GE(s.completedDepth, 1);
+    EXPECT_GT(s.nodes_searched(), 0);
+}
+
+TEST(LazySmpSearchTests, RootPositionIsLeftUntouched) {
+    Position  pos;
+    StateInfo st;
+    pos.set("rhfvsfhr/pppppppp/8/8/8/8/PPPPPPPP/RHFVSFHR w 0 1", &st, true);
+    const Key key = pos.key();
+
+    TranspositionTable tt;
+    tt.resize(64);
+    lazy_smp_search<true> s(&tt, pos, 3);
+    Move m = s.iterative_deepening(3);
+
+    EXPECT_EQ(pos.key(), key);
+    EXPECT_EQ(pos.st, &st);
+    EXPECT_TRUE(MoveList<LEGAL>(pos).contains(m));
+}
@@ -15,7 +15,6 @@ int main(int argc, char** argv) {
     shatranj::Piece::InitCapturePerSquareTable();
     shatranj::Piece::InitMovePerSquareTable();
     Bitboards::init();
-    Position::init();
     ::testing::InitGoogleTest(&argc, argv);
     struct timeval time;
     gettimeofday(&time, NULL);
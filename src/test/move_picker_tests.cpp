@@ -0,0 +1,113 @@
+#include "custommovepicker.h"
+#include "movegen.h"
+#include "stockfish_position.h"
+#include "types.h"
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+using namespace Stockfish;
+
+namespace {
+std::vector<Move> picked_legal_moves(Position&               pos,
+                                     Move                    ttm,
+                                     const Move*             killers,
+                                     const ButterflyHistory& history = ButterflyHistory(),
+                                     Move                    cm      = Move::none()) {
+    std::vector<Move> picked;
+    CustomMovePicker  mp(pos, ttm, killers, &history, cm);
+    Move              m;
+    while ((m = mp.next_move()) != Move::none())
+        if (pos.legal(m))
+            picked.push_back(m);
+    return picked;
+}
+}
+
+TEST(MovePickerTests, YieldsEveryLegalMoveOnce) {
+    const std::pair<const char*, bool> fens[] = {
+      {"rhfvsfhr/pppppppp/8/8/8/8/PPPPPPPP/RHFVSFHR w 0 1", true},
+      {"1r1r4/8/1h6/2p5/2P5/1HS5/R3R3/1s6 b 0 10", true},
+      {"k6r/8/3B4/6P1/4n3/2P5/1K3R2/8 b - - 0 1", false},
+      {"4k3/r7/8/8/4n1PK/8/8/8 b - - 0 1", false},
+      {"2rrnb2/8/bRp1pppp/k1n5/p1P3p1/P1KQB1PP/1RNPN3/5B2 b - - 0 1", false},
+    };
+    const Move noKillers[2] = {Move::none(), Move::none()};
+
+    for (auto [fen, shatranj] : fens)
+    {
+        Position  pos;
+        StateInfo st;
+        pos.set(fen, &st, shatranj);
+
+        std::vector<Move> legal;
+        for (auto& m : MoveList<LEGAL>(pos))
+            legal.push_back(m);
+
+        std::vector<Move> picked = picked_legal_moves(pos, Move::none(), noKillers);
+        auto              byRaw  = [](Move a, Move b) { return a.raw() < b.raw(); };
+        std::sort(legal.begin(), legal.end(), byRaw);
+        std::sort(picked.begin(), picked.end(), byRaw);
+        EXPECT_EQ(picked, legal) << fen;
+    }
+}
+
+TEST(MovePickerTests, TTMoveAndKillersComeFirst) {
+    Position  pos;
+    StateInfo st;
+    pos.set("rhfvsfhr/pppppppp/8/8/8/8/PPPPPPPP/RHFVSFHR w 0 1", &st, true);
+
+    const Move killers[2] = {Move(SQ_B1, SQ_C3), Move(SQ_A2, SQ_A3)};
+    auto       picked     = picked_legal_moves(pos, Move(SQ_G1, SQ_F3), killers);
+
+    ASSERT_GE(picked.size(), 3u);
+    EXPECT_EQ(picked[0], Move(SQ_G1, SQ_F3));
+    EXPECT_EQ(picked[1], killers[0]);
+    EXPECT_EQ(picked[2], killers[1]);
+    EXPECT_EQ(picked.size(), MoveList<LEGAL>(pos).size());
+
+    // A TT move that is not pseudo legal here is dropped without generation
+    auto withBadTT = picked_legal_moves(pos, Move(SQ_A1, SQ_A5), killers);
+    EXPECT_EQ(withBadTT.size(), MoveList<LEGAL>(pos).size());
+    EXPECT_EQ(std::count(withBadTT.begin(), withBadTT.end(), Move(SQ_A1, SQ_A5)), 0);
+}
+
+TEST(MovePickerTests, HistoryAndCountermoveOrderQuiets) {
+    Position  pos;
+    StateInfo st;
+    pos.set("rhfvsfhr/pppppppp/8/8/8/8/PPPPPPPP/RHFVSFHR w 0 1", &st, true);
+
+    const Move       noKillers[2] = {Move::none(), Move::none()};
+    ButterflyHistory history;
+    history.update(WHITE, Move(SQ_H2, SQ_H3), ButterflyHistory::HistoryMax);
+    history.update(WHITE, Move(SQ_A2, SQ_A3), -ButterflyHistory::HistoryMax);
+
+    auto picked = picked_legal_moves(pos, Move::none(), noKillers, history);
+    EXPECT_EQ(picked.front(), Move(SQ_H2, SQ_H3));
+    EXPECT_EQ(picked.back(), Move(SQ_A2, SQ_A3));
+
+    // The countermove is tried before any history ordered quiet, and only once
+    auto withCm = picked_legal_moves(pos, Move::none(), noKillers, history, Move(SQ_B1, SQ_C3));
+    EXPECT_EQ(withCm.front(), Move(SQ_B1, SQ_C3));
+    EXPECT_EQ(withCm[1], Move(SQ_H2, SQ_H3));
+    EXPECT_EQ(withCm.size(), MoveList<LEGAL>(pos).size());
+}
+
+TEST(MovePickerTests, StaticExchangeSeesRookXRay) {
+    Position  pos;
+    StateInfo st;
+
+    // Rd2xd5 Rxd5 Rxd5 wins the pawn thanks to the rook behind on d1
+    pos.set("3rk3/8/8/3p4/8/8/3R4/3RK3 w - - 0 1", &st, false);
+    EXPECT_TRUE(pos.see_ge(Move(SQ_D2, SQ_D5), 0));
+    EXPECT_FALSE(pos.see_ge(Move(SQ_D2, SQ_D5), PawnValue + 1));
+
+    // Without it the rook is lost for a pawn
+    pos.set("3rk3/8/8/3p4/8/8/3R4/4K3 w - - 0 1", &st, false);
+    EXPECT_FALSE(pos.see_ge(Move(SQ_D2, SQ_D5), 0));
+
+    // The alfil leaps, the pawn between does not shield d5 from b3
+    pos.set("4k3/8/8/3p4/2p5/1b6/8/3RK3 w - - 0 1", &st, false);
+    EXPECT_FALSE(pos.see_ge(Move(SQ_D1, SQ_D5), 0));
+}
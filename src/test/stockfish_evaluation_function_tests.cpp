@@ -11,6 +11,10 @@
 #include "evaluate.h"
 
 #include "custom_search.h"
+#include "eval_cache.h"
+#include "material.h"
+#include "pawns.h"
+#include "pesto_evaluate.h"
 #include "testhelper.h"
 #include "tt.h"
 #include "evaluate.h"
@@ -310,3 +314,147 @@ TEST(EvaluationTests, book_questions) {
     }
     std::cout << "successes: " << successes << " wrongs: " << wrongs << std::endl;
 }
+
+namespace {
+void check_pesto_sums(Position& pos, int depth) {
+    EXPECT_EQ(eval_PeSTO(pos), eval_PeSTO_full(pos)) << pos.fen();
+    if (depth == 0)
+        return;
+    StateInfo st;
+    for (const auto& m : MoveList<LEGAL>(pos))
+    {
+        pos.do_move(m, st);
+        check_pesto_sums(pos, depth - 1);
+        pos.undo_move(m);
+    }
+}
+}
+
+// The sums do_move() keeps in StateInfo must match a full recompute after
+// quiet moves, captures and promotions alike
+TEST(EvaluationTests, incremental_pesto_matches_full) {
+    for (auto fen : {"rhfvsfhr/pppppppp/8/8/8/8/PPPPPPPP/RHFVSFHR w 0 1",
+                     "2r1s3/1P4p1/3h4/2f5/5F2/4H3/1p4P1/2R1S3 w 0 1",
+                     "2r1s3/1P4p1/3h4/2f5/5F2/4H3/1p4P1/2R1S3 b 0 1"})
+    {
+        Position  pos;
+        StateInfo st;
+        pos.set(fen, &st, true);
+        check_pesto_sums(pos, 3);
+    }
+}
+
+TEST(EvaluationTests, pawn_structure_terms) {
+    Position  pos;
+    StateInfo st;
+    // White: a passed pawn on b6 and doubled pawns on the e file, the black
+    // pawn on d7 keeps them from being passed. g6 and g7 block each other.
+    pos.set("4s3/3p2p1/1P4P1/8/4P3/4P3/8/4S3 w 0 1", &st, true);
+
+    Pawns::Entry e;
+    Pawns::compute(pos, e);
+    EXPECT_EQ(e.passedPawns[WHITE], square_bb(SQ_B6));
+    EXPECT_EQ(e.passedPawns[BLACK], Bitboard(0));
+    EXPECT_TRUE(e.pawnAttacks[BLACK] & SQ_F6);
+    EXPECT_TRUE(e.pawnAttacksSpan[WHITE] & SQ_D8);
+
+    // A second probe of the same pawn structure is a hit with the same terms
+    Pawns::Table        table;
+    const Pawns::Entry* first = table.probe(pos);
+    EXPECT_EQ(first->mg, e.mg);
+    EXPECT_EQ(first->eg, e.eg);
+    table.probe(pos);
+    EXPECT_EQ(table.probes(), 2u);
+    EXPECT_EQ(table.hits(), 1u);
+    EXPECT_EQ(evaluate(pos, &table), evaluate(pos));
+}
+
+TEST(EvaluationTests, material_table_endings) {
+    StateInfo st;
+    Position  pos;
+
+    // Rook against ferz, for black as the strong side too
+    pos.set("8/8/3v4/3s4/8/8/2R5/4S3 w 0 1", &st, true);
+    Material::Entry e;
+    Material::compute(pos, e);
+    EXPECT_TRUE(e.specialized_eval_exists());
+    EXPECT_EQ(e.strongSide, WHITE);
+    EXPECT_GT(evaluate(pos), 0);
+
+    pos.set("4s3/2r5/8/8/3S4/3V4/8/8 b 0 1", &st, true);
+    Material::compute(pos, e);
+    EXPECT_EQ(e.strongSide, BLACK);
+    EXPECT_GT(evaluate(pos), 0);
+
+    // Any material against a bare king is a known win for the side to move
+    pos.set("8/8/8/3s4/8/5H2/2R5/4S3 w 0 1", &st, true);
+    EXPECT_GE(evaluate(pos), KnownWin);
+
+    // One rook each scales the evaluation down
+    pos.set("3r4/8/8/3s4/8/8/2R5/4S3 w 0 1", &st, true);
+    Material::compute(pos, e);
+    EXPECT_FALSE(e.specialized_eval_exists());
+    EXPECT_LT(e.scale_factor(pos, WHITE), ScaleFactorNormal);
+
+    // The table caches by material, a different placement is a hit
+    Material::Table table;
+    table.probe(pos);
+    pos.set("4r3/8/8/4s3/8/8/3R4/4S3 w 0 1", &st, true);
+    table.probe(pos);
+    EXPECT_EQ(table.hits(), 1u);
+}
+
+TEST(EvaluationTests, eval_cache_round_trip) {
+    StateInfo st;
+    Position  pos;
+    pos.set("1r4s1/8/5PP1/S1h5/6HR/7F/1r6/7R w 0 10", &st, true);
+
+    EvalCache cache;
+    Value     v = VALUE_ZERO;
+    EXPECT_FALSE(cache.probe(pos.key(), v));
+    cache.store(pos.key(), Value(-1234));
+    EXPECT_TRUE(cache.probe(pos.key(), v));
+    EXPECT_EQ(v, Value(-1234));
+    // Same slot, different upper key bits
+    EXPECT_FALSE(cache.probe(pos.key() ^ (Key(1) << 40), v));
+
+    cache.clear();
+    EXPECT_FALSE(cache.probe(pos.key(), v));
+
+    // Searches through the cache return the same move as one without it, the
+    // second one after a TT clear takes its evaluations from the cache
+    TranspositionTable tt;
+    tt.resize(16);
+    Stockfish::search<false> plain(&tt, pos);
+    Move                     expected = plain.iterative_deepening(5);
+    tt.clear();
+    Stockfish::search<false> cold(&tt, pos);
+    cold.set_eval_cache(&cache);
+    EXPECT_EQ(cold.iterative_deepening(5), expected);
+    tt.clear();
+    Stockfish::search<false> warm(&tt, pos);
+    warm.set_eval_cache(&cache);
+    EXPECT_EQ(warm.iterative_deepening(5), expected);
+    EXPECT_GT(warm.eval_cache_hits(), warm.eval_cache_probes() / 2);
+
+    cache.resize(0);
+    EXPECT_FALSE(cache.enabled());
+}
+
+// Rook takes the alfil and black, not in check and still ahead of its stand
+// pat window, has no move left: stalemate, which shatranj scores as a win.
+// King takes alfil is the best move by material alone
+TEST(EvaluationTests, stalemating_move_is_a_win) {
+    for (int depth : {1, 5})
+    {
+        Position  pos;
+        StateInfo st;
+        pos.set("8/Sf5R/8/8/8/8/p5V1/s7 w 0 1", &st, true);
+
+        TranspositionTable tt;
+        tt.resize(16);
+        search<false> s(&tt, pos);
+        EXPECT_EQ(s.iterative_deepening(depth), Move(SQ_H7, SQ_B7)) << "depth " << depth;
+        EXPECT_EQ(s.picked_move_score(), mate_in(1)) << "depth " << depth;
+    }
+}
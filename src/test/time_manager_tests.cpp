@@ -0,0 +1,93 @@
+#include "custom_search.h"
+#include "movegen.h"
+#include "stockfish_position.h"
+#include "timeman.h"
+#include "tt.h"
+#include "types.h"
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+using namespace Stockfish;
+
+TEST(TimeManagerTests, SuddenDeathKeepsAReserve) {
+    LimitsType limits;
+    limits.time[WHITE] = 60000;
+    limits.time[BLACK] = 1000;
+
+    TimeManagement tm;
+    tm.init(limits, WHITE, 20);
+    EXPECT_GT(tm.optimum(), 0);
+    EXPECT_LT(tm.optimum(), 60000 / 20);
+    EXPECT_GE(tm.maximum(), tm.optimum());
+    EXPECT_LE(tm.maximum(), 60000 * 84 / 100);
+
+    // The side to move's clock is the one that counts
+    TimeManagement low;
+    low.init(limits, BLACK, 20);
+    EXPECT_LT(low.maximum(), tm.optimum());
+
+    // An increment is worth spending
+    limits.inc[WHITE] = 2000;
+    TimeManagement withInc;
+    withInc.init(limits, WHITE, 20);
+    EXPECT_GT(withInc.optimum(), tm.optimum());
+}
+
+TEST(TimeManagerTests, MovesToGoAndMovetime) {
+    LimitsType limits;
+    limits.time[WHITE] = 10000;
+    limits.movestogo   = 1;
+
+    // The last move before the control may use most, but never all, of the clock
+    TimeManagement tm;
+    tm.init(limits, WHITE, 40);
+    EXPECT_GT(tm.optimum(), 5000);
+    EXPECT_LE(tm.maximum(), 10000 - TimeManagement::MoveOverhead);
+
+    LimitsType fixed;
+    fixed.movetime = 250;
+    tm.init(fixed, WHITE, 0);
+    EXPECT_EQ(tm.optimum(), 250);
+    EXPECT_EQ(tm.maximum(), 250);
+}
+
+TEST(TimeManagerTests, SoftLimitFollowsSearchStability) {
+    LimitsType limits;
+    limits.time[WHITE] = 60000;
+
+    TimeManagement tm;
+    tm.init(limits, WHITE, 10);
+    TimePoint settled = tm.soft_limit(0, VALUE_ZERO, 0.5);
+
+    EXPECT_GT(tm.soft_limit(1.0, VALUE_ZERO, 0.5), settled);
+    EXPECT_GT(tm.soft_limit(0, Value(100), 0.5), settled);
+    EXPECT_LT(tm.soft_limit(0, Value(-100), 0.5), settled);
+    EXPECT_LT(tm.soft_limit(0, VALUE_ZERO, 0.95), settled);
+    EXPECT_EQ(tm.soft_limit(100.0, Value(1000), 0.5), tm.maximum());
+}
+
+TEST(TimeManagerTests, ClockSearchEndsWithinTheHardLimit) {
+    Position  pos;
+    StateInfo st;
+    pos.set("rhfvsfhr/pppppppp/8/8/8/8/PPPPPPPP/RHFVSFHR w 0 1", &st, true);
+
+    LimitsType limits;
+    limits.time[WHITE] = 2000;
+    limits.time[BLACK] = 2000;
+    TimeManagement tm;
+    tm.init(limits, WHITE, 0);
+
+    TranspositionTable tt;
+    tt.resize(16);
+    search<true> s(&tt, pos);
+    auto         begin   = std::chrono::steady_clock::now();
+    Move         m       = s.iterative_deepening(limits);
+    auto         elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::steady_clock::now() - begin)
+                     .count();
+
+    EXPECT_TRUE(MoveList<LEGAL>(pos).contains(m));
+    EXPECT_GE(s.completedDepth, 1);
+    EXPECT_LE(elapsed, tm.maximum() + 50);
+}
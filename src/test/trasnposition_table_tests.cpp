@@ -6,10 +6,14 @@
 #include "board.h"
 #include "stockfish_position.h"
 #include <chrono>
+#include <filesystem>
+#include <fstream>
 #include <cstdint>
 #include <iomanip>
 #include <limits>
+#include "custom_search.h"
 #include "customtranspositiontable.h"
+#include "lazy_smp_search.h"
 #include "tt.h"
 #include "types.h"
 
@@ -162,3 +166,152 @@ TEST(TranspositionTableTests, Test_Stockfish) {
     std::cout << "ttmiss : " << ttmiss << "  %" << ttmiss * 100 / (tthit + ttmiss) << std::endl;
     EXPECT_GE(tthit * 100 / (tthit + ttmiss), 95);
 }
+
+TEST(TranspositionTableTests, MateScoreIsRelativeToRoot) {
+    Position  pos;
+    StateInfo st;
+    pos.set("4k3/r7/8/8/4n1PK/8/8/8 b - - 0 1", &st, false);
+
+    TranspositionTable tt;
+    tt.resize(16);
+    for (int i = 0; i < 2; ++i)  // second run reads the mate back from the TT
+    {
+        search<true> s(&tt, pos);
+        EXPECT_EQ(s.iterative_deepening(4), Move(SQ_A7, SQ_H7));
+        EXPECT_EQ(s.picked_move_score(), mate_in(1));
+    }
+}
+
+TEST(TranspositionTableTests, WarmTableCutsNodes) {
+    Position  pos;
+    StateInfo st;
+    pos.set("1r1r4/8/1h6/2p5/2P5/1HS5/R3R3/1s6 b 0 10", &st, true);
+
+    TranspositionTable tt;
+    tt.resize(16);
+    search<true> cold(&tt, pos);
+    Move         coldMove = cold.iterative_deepening(5);
+    search<true> warm(&tt, pos);
+    Move         warmMove = warm.iterative_deepening(5);
+
+    EXPECT_EQ(coldMove, warmMove);
+    EXPECT_LT(warm.nodes_searched(), cold.nodes_searched());
+}
+
+// One new generation per go however many threads search, and the entries of
+// the last search are the ones hashfull() counts
+TEST(TranspositionTableTests, EverySearchOpensOneGeneration) {
+    Position  pos;
+    StateInfo st;
+    pos.set("1r1r4/8/1h6/2p5/2P5/1HS5/R3R3/1s6 b 0 10", &st, true);
+
+    TranspositionTable tt;
+    tt.resize(1);
+    lazy_smp_search<true> s(&tt, pos, 3);
+
+    uint8_t generation = tt.generation();
+    s.iterative_deepening(5);
+    EXPECT_EQ(tt.generation(), uint8_t(generation + 8));
+    EXPECT_GT(tt.hashfull(), 0);
+    EXPECT_GT(s.tt_probes(), 0u);
+
+    s.iterative_deepening(5);
+    EXPECT_EQ(tt.generation(), uint8_t(generation + 16));
+    EXPECT_GT(s.tt_hits(), 0u);
+}
+
+// Growing and shrinking with keepEntries finds every entry of a lightly
+// loaded table again, clearing on several threads finds none
+TEST(TranspositionTableTests, ResizeKeepsEntries) {
+    TranspositionTable tt;
+    tt.resize(1);
+    tt.new_search();
+
+    PRNG             rng(1070372);
+    std::vector<Key> keys(2000);
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        keys[i]                        = rng.rand<Key>();
+        auto [ttHit, ttData, ttWriter] = tt.probe(keys[i]);
+        ttWriter.write(keys[i], Value(i), false, BOUND_EXACT, 6, Move::none(), VALUE_ZERO,
+                       tt.generation());
+    }
+
+    auto expectAll = [&]() {
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            auto [ttHit, ttData, ttWriter] = tt.probe(keys[i]);
+            ASSERT_TRUE(ttHit);
+            EXPECT_EQ(ttData.value, Value(i));
+        }
+    };
+
+    tt.resize(4, 3, true);
+    expectAll();
+    tt.resize(1, 2, true);
+    expectAll();
+    tt.resize(3, 4, true);
+    expectAll();
+
+    tt.clear(4);
+    EXPECT_EQ(tt.hashfull(), 0);
+    for (Key k : keys)
+        EXPECT_FALSE(std::get<0>(tt.probe(k)));
+}
+
+// A snapshot brings back the entries, size and generation. Writes to a loaded
+// table stay out of the file, and a file of another layout is refused
+TEST(TranspositionTableTests, SnapshotSaveAndLoad) {
+    const std::string path =
+      (std::filesystem::temp_directory_path() / "tt_snapshot_test.tt").string();
+
+    TranspositionTable tt;
+    tt.resize(2);
+    tt.new_search();
+    tt.new_search();
+
+    PRNG             rng(42);
+    std::vector<Key> keys(1000);
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        keys[i]                        = rng.rand<Key>();
+        auto [ttHit, ttData, ttWriter] = tt.probe(keys[i]);
+        ttWriter.write(keys[i], Value(i), false, BOUND_LOWER, 7, Move::none(), VALUE_ZERO,
+                       tt.generation());
+    }
+    ASSERT_TRUE(tt.save(path));
+
+    TranspositionTable loaded;
+    loaded.resize(1);
+    ASSERT_TRUE(loaded.load(path));
+    EXPECT_EQ(loaded.generation(), tt.generation());
+    EXPECT_EQ(loaded.hashfull(), tt.hashfull());
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        auto [ttHit, ttData, ttWriter] = loaded.probe(keys[i]);
+        ASSERT_TRUE(ttHit);
+        EXPECT_EQ(ttData.value, Value(i));
+        EXPECT_EQ(ttData.bound, BOUND_LOWER);
+        ttWriter.write(keys[i], Value(-1), false, BOUND_EXACT, 9, Move::none(), VALUE_ZERO,
+                       loaded.generation());
+    }
+
+    TranspositionTable again;
+    ASSERT_TRUE(again.load(path));
+    EXPECT_EQ(std::get<1>(again.probe(keys[5])).value, Value(5));
+
+    // A mapped table can be resized and cleared like an allocated one
+    loaded.resize(4, 2, true);
+    EXPECT_EQ(std::get<1>(loaded.probe(keys[1])).value, Value(-1));
+
+    {
+        std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+        f.seekp(8);
+        f.put(char(0x7f));
+    }
+    EXPECT_FALSE(again.load("does/not/exist.tt"));
+    EXPECT_FALSE(again.load(path));
+    EXPECT_EQ(std::get<1>(again.probe(keys[5])).value, Value(5));
+
+    std::filesystem::remove(path);
+}
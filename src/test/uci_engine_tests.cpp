@@ -0,0 +1,91 @@
+#include "uci_engine.h"
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+using namespace shatranj;
+
+TEST(UCIEngineTests, PositionCommandAppliesMoves) {
+    UCIEngine engine;
+    EXPECT_TRUE(engine.set_position(UCIEngine::StartFEN, {"e2e3", "e7e6", "g1f3"}));
+    EXPECT_EQ(engine.position().gamePly, 3);
+    EXPECT_EQ(engine.position().side_to_move(), Stockfish::BLACK);
+    EXPECT_EQ(to_uci(to_move(engine.position(), "g8f6")), "g8f6");
+
+    // A pawn can not push two squares in shatranj
+    EXPECT_FALSE(engine.set_position(UCIEngine::StartFEN, {"e2e3", "e7e5"}));
+    EXPECT_EQ(engine.position().gamePly, 1);
+}
+
+TEST(UCIEngineTests, GoReportsInfoAndBestmove) {
+    UCIEngine engine;
+    engine.set_position("4s3/r7/8/8/4h1PS/8/8/8 b - - 0 1", {});
+
+    Stockfish::LimitsType limits;
+    limits.depth = 4;
+    testing::internal::CaptureStdout();
+    engine.go(limits);
+    engine.wait();
+    std::string out = testing::internal::GetCapturedStdout();
+
+    EXPECT_NE(out.find("info depth 1 seldepth"), std::string::npos);
+    EXPECT_NE(out.find(" hashfull "), std::string::npos);
+    EXPECT_NE(out.find("bestmove a7h7"), std::string::npos);
+}
+
+TEST(UCIEngineTests, BadNumbersInCommandsAreIgnored) {
+    UCIEngine engine;
+
+    testing::internal::CaptureStdout();
+    EXPECT_NO_THROW(engine.handle_setoption(split("setoption name Hash value abc")));
+    EXPECT_NO_THROW(engine.handle_setoption(split("setoption name Threads value 2x")));
+    engine.handle_position(split("position fen 4s3/r7/8/8/4h1PS/8/8/8 b - - 0 1"));
+    EXPECT_NO_THROW(engine.handle_go(split("go wtime x btime -- depth 4")));
+    engine.wait();
+    std::string out = testing::internal::GetCapturedStdout();
+
+    EXPECT_NE(out.find("info string invalid value abc for option Hash"), std::string::npos);
+    EXPECT_NE(out.find("info string invalid value x for wtime"), std::string::npos);
+    EXPECT_NE(out.find("bestmove a7h7"), std::string::npos);
+}
+
+TEST(UCIEngineTests, StopEndsAnInfiniteSearch) {
+    UCIEngine engine;
+    engine.set_threads(2);
+
+    testing::internal::CaptureStdout();
+    engine.go(Stockfish::LimitsType());
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    // Without stop() an infinite search never returns, wait() would hang
+    engine.stop();
+    engine.wait();
+    std::string out = testing::internal::GetCapturedStdout();
+
+    EXPECT_NE(out.find("bestmove "), std::string::npos);
+    EXPECT_EQ(out.find("bestmove (none)"), std::string::npos);
+}
+
+TEST(UCIEngineTests, PositionCommandsReuseTheCommonPrefix) {
+    const std::vector<std::string> game = {"g1f3", "g8f6", "f3g1", "f6g8", "b1c3", "b8c6"};
+
+    UCIEngine fresh;
+    fresh.set_position(UCIEngine::StartFEN, game);
+
+    UCIEngine incremental;
+    for (size_t n = 0; n <= game.size(); n++) {
+        incremental.set_position(UCIEngine::StartFEN, {game.begin(), game.begin() + n});
+    }
+    EXPECT_EQ(incremental.position().key(), fresh.position().key());
+    EXPECT_EQ(incremental.position().gamePly, 6);
+
+    // The start position is on the board again after four plies
+    incremental.set_position(UCIEngine::StartFEN, {game.begin(), game.begin() + 4});
+    EXPECT_EQ(incremental.position().st->repetition, 4);
+
+    // A take back followed by a different move
+    incremental.set_position(UCIEngine::StartFEN, {"g1f3", "g8f6", "b1c3"});
+    fresh.set_position(UCIEngine::StartFEN, {"g1f3", "g8f6", "b1c3"});
+    EXPECT_EQ(incremental.position().key(), fresh.position().key());
+    EXPECT_EQ(incremental.position().gamePly, 3);
+}